@@ -0,0 +1,96 @@
+#include "Calibration.h"
+#include "Foreperiod.h"
+#include "Ring_Buffer.h"
+
+volatile uint32_t calibrationOffset_us = 0;
+
+// Synthetic press offsets after onset. Always longer than the user button
+// lockout, since the line goes low again just after each press.
+constexpr ForeperiodConfig offsetConfig = {
+    ForeperiodDistribution::Uniform,
+    100000,   // min 100 ms
+    500000,   // max 500 ms
+    0,
+};
+constexpr auto pulseWidth = 30ms;  // High time of a press
+constexpr auto nextDelay = 200ms;  // Result → next start press
+
+// TIM2_CH2 output compare modes (OC2M)
+constexpr uint32_t ocForceLow = 4UL << TIM_CCMR1_OC2M_Pos;
+constexpr uint32_t ocForceHigh = 5UL << TIM_CCMR1_OC2M_Pos;
+constexpr uint32_t ocHighOnMatch = 1UL << TIM_CCMR1_OC2M_Pos;
+
+static volatile bool active = false;
+static RingBuffer<uint32_t, 8> nominals;  // Offsets in flight, ISR → thread
+static SessionStats latency;
+static Timeout releaseTimer;  // Returns the line low after a press
+static Timeout nextTimer;     // Next start press
+
+static void setMode(uint32_t mode) {
+    TIM2->CCMR1 = (TIM2->CCMR1 & ~TIM_CCMR1_OC2M) | mode;
+}
+
+static void release() {
+    setMode(ocForceLow);
+}
+
+static void startPress() {
+    setMode(ocForceHigh);
+    releaseTimer.attach(&release, pulseWidth);
+}
+
+void calibrationInit() {
+    RCC->AHB1ENR |= RCC_AHB1ENR_GPIOBEN;
+    (void)RCC->AHB1ENR; // Let the clock enable settle
+
+    // PB3 → alternate function 1 (TIM2_CH2)
+    GPIOB->MODER = (GPIOB->MODER & ~(3UL << 6)) | (2UL << 6);
+    GPIOB->AFR[0] = (GPIOB->AFR[0] & ~(0xFUL << 12)) | (1UL << 12);
+
+    // CH2 = output, no preload (CCR2 takes effect at once), idle low
+    TIM2->CCMR1 = (TIM2->CCMR1 & ~(TIM_CCMR1_CC2S | TIM_CCMR1_OC2M | TIM_CCMR1_OC2PE)) | ocForceLow;
+    TIM2->CCER |= TIM_CCER_CC2E;
+}
+
+void calibrationStart() {
+    latency.reset();
+    active = true;
+    startPress();
+}
+
+bool calibrationActive() {
+    return active;
+}
+
+void calibrationOnStimulus(uint32_t onset) {
+    uint32_t offset = foreperiodNext(offsetConfig);
+    nominals.push(offset);
+    TIM2->CCR2 = onset + offset;
+    setMode(ocHighOnMatch);
+    releaseTimer.attach(&release, std::chrono::microseconds(offset) + pulseWidth);
+}
+
+void calibrationOnResult() {
+    nextTimer.attach(&startPress, nextDelay);
+}
+
+void calibrationRecord(uint32_t reported_us) {
+    uint32_t nominal;
+    if (nominals.pop(nominal)) {
+        latency.add(reported_us > nominal ? reported_us - nominal : 0);
+    }
+}
+
+CalibrationResult calibrationFinish() {
+    active = false;
+    nextTimer.detach();
+
+    CalibrationResult result;
+    result.offset_us = (uint32_t)(latency.mean + 0.5f);
+    result.jitter_us = (uint32_t)(sqrtf(latency.variance()) + 0.5f);
+    result.min_us = latency.min;
+    result.max_us = latency.max;
+
+    calibrationOffset_us = result.offset_us;
+    return result;
+}
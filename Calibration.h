@@ -0,0 +1,86 @@
+/**
+ * =====================================================
+ * Calibration – latency self-test of the measurement chain
+ * =====================================================
+ *
+ * Wiring: jumper PB3 (TIM2_CH2) to PA0 (BUTTON1). BUTTON1 is active high
+ * (pulled down on the board), so the line idles low and a rising edge on
+ * it looks exactly like a button press.
+ *
+ * Each synthetic trial goes through the normal FSM:
+ *   - a short high pulse on PB3 is the start press,
+ *   - when the stimulus comes on, TIM2 output compare drives PB3 high at
+ *     exactly onset + offset, with the offset drawn at random,
+ *   - the press is then captured and reported exactly like a human one.
+ *
+ * Latency = reported − offset. The offset is applied by the timer
+ * hardware, so any difference is the measurement path itself: input
+ * filter and synchroniser with HW_CAPTURE, plus ISR entry and the Timer
+ * read without it. Its mean is the fixed offset subtracted from later
+ * BUTTON1 results (the path it measured), and its SD is the jitter.
+ *
+ * =====================================================
+ */
+
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include "Session_Stats.h"
+#include "mbed.h"
+
+constexpr uint32_t calibrationTrials = 50;
+
+struct CalibrationResult {
+    uint32_t offset_us;   // Mean latency, subtracted from reported times
+    uint32_t jitter_us;   // SD of the latency
+    uint32_t min_us;
+    uint32_t max_us;
+};
+
+/**
+ * @brief Puts PB3 under TIM2_CH2 and drives it low. captureTimerInit()
+ * must have run first.
+ */
+void calibrationInit();
+
+/**
+ * @brief Starts a calibration run and fires the first start press.
+ */
+void calibrationStart();
+
+/**
+ * @brief True between calibrationStart() and calibrationFinish().
+ */
+bool calibrationActive();
+
+/**
+ * @brief Stimulus is on: schedules the synthetic press at a random known
+ * offset after onset. ISR context.
+ */
+void calibrationOnStimulus(uint32_t onset);
+
+/**
+ * @brief A trial finished: schedules the next start press. ISR context.
+ */
+void calibrationOnResult();
+
+/**
+ * @brief Folds one reported time into the latency distribution. Thread
+ * context, one call per calibration trial, in order.
+ */
+void calibrationRecord(uint32_t reported_us);
+
+/**
+ * @brief Ends the run, publishes the offset and returns the figures.
+ * Thread context.
+ */
+CalibrationResult calibrationFinish();
+
+/**
+ * @brief Offset to subtract from reaction times reported through BUTTON1
+ * (µs, 0 until a calibration has run). Set by calibrationFinish() and,
+ * at boot, from the stored value. Read from the press ISR.
+ */
+extern volatile uint32_t calibrationOffset_us;
+
+#endif // CALIBRATION_H
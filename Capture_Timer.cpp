@@ -0,0 +1,69 @@
+#include "Capture_Timer.h"
+
+volatile uint32_t captureTimerLatched = 0;
+
+// DMA1 Stream 5, channel 3 is the TIM2_CH1 capture request
+constexpr uint32_t latchChannel = 3;
+constexpr uint32_t latchFlags = DMA_HIFCR_CTCIF5 | DMA_HIFCR_CHTIF5 | DMA_HIFCR_CTEIF5 |
+                                DMA_HIFCR_CDMEIF5 | DMA_HIFCR_CFEIF5;
+
+/**
+ * @brief Returns the TIM2 input clock. APB1 timers run at twice PCLK1
+ * whenever the APB1 prescaler is not 1.
+ */
+static uint32_t timer2Clock() {
+    uint32_t pclk1 = HAL_RCC_GetPCLK1Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) {
+        return pclk1 * 2;
+    }
+    return pclk1;
+}
+
+void captureTimerInit(uint8_t filter, CaptureInput input) {
+    RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;
+    (void)RCC->APB1ENR; // Let the clock enable settle
+
+    if (input == CaptureInput::Touch) {
+        // PA15 → alternate function 1 (TIM2_CH1)
+        GPIOA->MODER = (GPIOA->MODER & ~(3UL << 30)) | (2UL << 30);
+        GPIOA->AFR[1] = (GPIOA->AFR[1] & ~(0xFUL << 28)) | (1UL << 28);
+    } else {
+        // PA0 → alternate function 1 (TIM2_CH1)
+        GPIOA->MODER = (GPIOA->MODER & ~(3UL << 0)) | (2UL << 0);
+        GPIOA->AFR[0] = (GPIOA->AFR[0] & ~(0xFUL << 0)) | (1UL << 0);
+    }
+
+    TIM2->CR1 = 0;
+    TIM2->PSC = timer2Clock() / 1000000 - 1; // 1 tick = 1 µs
+    TIM2->ARR = 0xFFFFFFFF;                  // Free-running, full 32 bits
+
+    // CH1 = input capture on TI1, glitch filter, press edge, DMA request:
+    // rising for BUTTON1 (active high), falling for the touch INT (active low)
+    TIM2->CCMR1 = (TIM2->CCMR1 & ~(TIM_CCMR1_CC1S | (0xFUL << TIM_CCMR1_IC1F_Pos))) |
+                  TIM_CCMR1_CC1S_0 | ((uint32_t)(filter & 0xF) << TIM_CCMR1_IC1F_Pos);
+    TIM2->CCER = (input == CaptureInput::Touch) ? TIM_CCER_CC1P | TIM_CCER_CC1E : TIM_CCER_CC1E;
+    TIM2->DIER |= TIM_DIER_CC1DE;
+
+    // One-shot latch: CCR1 → captureTimerLatched, 32-bit, one transfer
+    DMA1_Stream5->CR = 0;
+    DMA1_Stream5->PAR = (uint32_t)&TIM2->CCR1;
+    DMA1_Stream5->M0AR = (uint32_t)&captureTimerLatched;
+    DMA1_Stream5->CR = (latchChannel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PSIZE_1 | DMA_SxCR_MSIZE_1;
+
+    TIM2->EGR = TIM_EGR_UG; // Load PSC
+    TIM2->SR = 0;
+    TIM2->CR1 = TIM_CR1_CEN;
+}
+
+void captureTimerArm() {
+    DMA1_Stream5->CR &= ~DMA_SxCR_EN;
+    while (DMA1_Stream5->CR & DMA_SxCR_EN) {
+        // Disabling takes effect after any in-flight transfer
+    }
+    DMA1->HIFCR = latchFlags;
+    TIM2->SR = ~(TIM_SR_CC1IF | TIM_SR_CC1OF);
+
+    DMA1_Stream5->NDTR = 1;
+    DMA1_Stream5->CR |= DMA_SxCR_EN;
+}
@@ -0,0 +1,95 @@
+/**
+ * =====================================================
+ * Capture Timer – TIM2 hardware timestamping
+ * =====================================================
+ *
+ * TIM2 runs as a free-running 32-bit up-counter at 1 MHz, so one count is
+ * one microsecond and the counter wraps after ~71 minutes. Unsigned
+ * subtraction of two timestamps is therefore wrap-safe for any reaction
+ * time we can measure.
+ *
+ * Channel 1 input-captures the press edge of PA0 (BUTTON1, AF1): BUTTON1
+ * is active high (pulled down on the board), so that is the rising edge,
+ * the same one userButton.rise() reacts to. The counter value is latched
+ * by the timer itself at the edge, so ISR entry latency never reaches the
+ * result. With CaptureInput::Touch the channel is fed from PA15 (also
+ * TIM2_CH1 on AF1) instead, on the falling edge: the touch controller's
+ * active-low interrupt line.
+ *
+ * Contact bounce: each capture raises a DMA request, and DMA1 Stream 5 is
+ * armed for exactly one transfer per trial. The first edge's count is
+ * copied out of CCR1 before any bounce edge can overwrite it; later edges
+ * find the stream finished and are ignored. The TIM2 digital input filter
+ * additionally rejects glitches shorter than a few microseconds.
+ *
+ * TIM5 is left alone: Mbed uses it for the us_ticker on this target.
+ *
+ * =====================================================
+ */
+
+#ifndef CAPTURE_TIMER_H
+#define CAPTURE_TIMER_H
+
+#include "mbed.h"
+
+#ifndef SIM_HOST
+#define SIM_HOST 0
+#endif
+
+/**
+ * Pin that drives TIM2 channel 1.
+ */
+enum class CaptureInput : uint8_t {
+    Button,   // PA0, BUTTON1
+    Touch,    // PA15, STMPE811 INT
+};
+
+/**
+ * @brief Configures TIM2 as a 1 MHz free-running counter with input capture
+ * on PA0 or PA15. Must be called after the pin's InterruptIn has claimed
+ * it, because the pin is switched to its timer alternate function here
+ * (EXTI keeps working, the input path stays enabled in AF mode).
+ * @param filter TIM2 IC1F input filter setting, 0 (off) to 15. 15 requires
+ * the level to be stable for 8 samples at fCK_INT/32 (~2.8 µs at 90 MHz).
+ * @param input Which pin is captured; only that one is switched to AF1.
+ */
+void captureTimerInit(uint8_t filter, CaptureInput input = CaptureInput::Button);
+
+/**
+ * @brief Arms the one-shot DMA latch for the next press and discards any
+ * edge captured so far, e.g. before the stimulus.
+ */
+void captureTimerArm();
+
+extern volatile uint32_t captureTimerLatched; // First edge since arming, written by DMA
+
+#if SIM_HOST
+// Host simulation (sim/): the counter is the virtual clock
+uint32_t captureTimerNow();
+uint32_t captureTimerPress();
+#else
+
+/**
+ * @brief Returns the current TIM2 count (microseconds, free-running).
+ */
+inline uint32_t captureTimerNow() {
+    return TIM2->CNT;
+}
+
+/**
+ * @brief Returns the timestamp of the first press edge on the input since
+ * captureTimerArm(). Falls back to the latest capture, then to the current
+ * count, so a caller always gets a usable timestamp.
+ */
+inline uint32_t captureTimerPress() {
+    if (DMA1_Stream5->NDTR == 0) {
+        return captureTimerLatched; // One-shot transfer done: first edge
+    }
+    if (TIM2->SR & TIM_SR_CC1IF) {
+        return TIM2->CCR1; // Reading CCR1 clears CC1IF
+    }
+    return TIM2->CNT;
+}
+#endif // SIM_HOST
+
+#endif // CAPTURE_TIMER_H
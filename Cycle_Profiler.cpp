@@ -0,0 +1,30 @@
+#include "Cycle_Profiler.h"
+
+ProbeStats probeTable[probeCount];
+
+static const char *const probeNames[probeCount] = {
+    "user_isr", "external_isr", "touch_isr", "stimulus_isr", "inactivity_isr",
+    "scan_isr", "record_result", "draw", "present",
+};
+
+void profilerInit() {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; // Enable the DWT block
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    profilerReset();
+}
+
+void profilerReset() {
+    for (ProbeStats &stats : probeTable) {
+        stats.count = 0;
+        stats.min = UINT32_MAX;
+        stats.max = 0;
+        for (uint16_t &bin : stats.bins) {
+            bin = 0;
+        }
+    }
+}
+
+const char *profilerName(Probe probe) {
+    return probeNames[static_cast<uint32_t>(probe)];
+}
@@ -0,0 +1,127 @@
+/**
+ * =====================================================
+ * Cycle Profiler – DWT cycle-count probes
+ * =====================================================
+ *
+ * Times code paths in CPU cycles with the Cortex-M4 DWT cycle counter
+ * (180 MHz on this board, so one cycle is 5.6 ns). A probe is a scope:
+ *
+ *   void user() {
+ *       PROFILE_SCOPE(Probe::UserIsr);
+ *       ...
+ *   }
+ *
+ * reads CYCCNT on entry and again on exit, and folds the difference into
+ * the probe's row of a static table: count, min, max and a power-of-two
+ * histogram. A probe costs two counter reads and a handful of ALU
+ * instructions; there is no buffer to drain and no locking. Each probe
+ * must be recorded from one context (or contexts that cannot preempt each
+ * other).
+ *
+ * PROFILING 0 removes every probe at compile time. It defaults to 0 in
+ * release builds (NDEBUG), 1 otherwise.
+ *
+ * =====================================================
+ */
+
+#ifndef CYCLE_PROFILER_H
+#define CYCLE_PROFILER_H
+
+#include "mbed.h"
+
+#ifndef PROFILING
+#ifdef NDEBUG
+#define PROFILING 0
+#else
+#define PROFILING 1
+#endif
+#endif
+
+// One row per instrumented path. Add a path by adding an entry here and
+// its name in Cycle_Profiler.cpp.
+enum class Probe : uint8_t {
+    UserIsr,        // Onboard button ISR, including its FSM action
+    ExternalIsr,    // External button ISR
+    TouchIsr,       // Touchscreen INT ISR
+    StimulusIsr,    // Foreperiod (and rapid-fire interval) timeout ISR
+    InactivityIsr,  // Dormant timeout ISR
+    ScanIsr,        // LTDC line hook: screen target scanned out
+    RecordResult,   // Deferred thread: one trial formatted and stored
+    Draw,           // Display thread: all changed lines drawn
+    Present,        // Display thread: swap, including the wait for vertical blanking
+    Count
+};
+
+constexpr uint32_t probeCount = static_cast<uint32_t>(Probe::Count);
+
+struct ProbeStats {
+    static constexpr uint32_t binCount = 24; // Bin i: [2^i, 2^(i+1)) cycles, last bin open-ended
+
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint16_t bins[binCount];
+};
+
+extern ProbeStats probeTable[probeCount];
+
+/**
+ * @brief Starts the DWT cycle counter and clears the table.
+ */
+void profilerInit();
+
+/**
+ * @brief Clears every probe's statistics.
+ */
+void profilerReset();
+
+/**
+ * @brief Short name of a probe, for the dump.
+ */
+const char *profilerName(Probe probe);
+
+/**
+ * @brief Folds one measurement into a probe's row.
+ */
+inline void profilerRecord(Probe probe, uint32_t cycles) {
+    ProbeStats &stats = probeTable[static_cast<uint32_t>(probe)];
+    stats.count++;
+    if (cycles < stats.min) {
+        stats.min = cycles;
+    }
+    if (cycles > stats.max) {
+        stats.max = cycles;
+    }
+    uint32_t bin = 31 - __CLZ(cycles | 1); // floor(log2), single instruction
+    if (bin >= ProbeStats::binCount) {
+        bin = ProbeStats::binCount - 1;
+    }
+    if (stats.bins[bin] < UINT16_MAX) {
+        stats.bins[bin]++;
+    }
+}
+
+/**
+ * @brief Times its own lifetime into one probe.
+ */
+class ProbeScope {
+public:
+    explicit ProbeScope(Probe probe) : probe(probe), start(DWT->CYCCNT) {
+    }
+
+    ~ProbeScope() {
+        profilerRecord(probe, DWT->CYCCNT - start); // Wrap-safe
+    }
+
+private:
+    Probe probe;
+    uint32_t start;
+};
+
+#if PROFILING
+#define PROFILE_SCOPE(probe) ProbeScope profileScope(probe)
+#else
+#define PROFILE_SCOPE(probe) ((void)0)
+#endif
+
+#endif // CYCLE_PROFILER_H
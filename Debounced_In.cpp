@@ -0,0 +1,45 @@
+#include "Debounced_In.h"
+
+DebouncedIn::DebouncedIn(PinName pin, PinMode mode, std::chrono::microseconds lockout)
+    : in(pin, mode), lockout(lockout) {
+}
+
+void DebouncedIn::fall(Callback<void()> handler) {
+    this->handler = handler;
+    in.fall(callback(this, &DebouncedIn::onPress));
+    in.rise(callback(this, &DebouncedIn::onRelease));
+}
+
+void DebouncedIn::rise(Callback<void()> handler) {
+    this->handler = handler;
+    in.rise(callback(this, &DebouncedIn::onPress));
+    in.fall(callback(this, &DebouncedIn::onRelease));
+}
+
+void DebouncedIn::set_lockout(std::chrono::microseconds lockout) {
+    this->lockout = lockout;
+}
+
+void DebouncedIn::onPress() {
+    if (locked) {
+        lock(); // Still bouncing: restart the quiet window
+        return;
+    }
+    lock();
+    if (handler) {
+        handler();
+    }
+}
+
+void DebouncedIn::onRelease() {
+    lock();
+}
+
+void DebouncedIn::lock() {
+    locked = true;
+    lockoutTimer.attach(callback(this, &DebouncedIn::unlock), lockout);
+}
+
+void DebouncedIn::unlock() {
+    locked = false;
+}
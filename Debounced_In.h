@@ -0,0 +1,65 @@
+/**
+ * =====================================================
+ * Debounced Input – edge lockout without delaying the first edge
+ * =====================================================
+ *
+ * Wraps an InterruptIn. The first press edge (falling for an active-low
+ * input, rising for an active-high one) is passed to the handler
+ * immediately (its time has already been latched, in hardware for
+ * userButton), then every further edge is ignored until the line has been
+ * quiet for the lockout window. The window is timed by a Timeout, never a
+ * busy wait.
+ *
+ * Release edges do not call the handler but also start the lockout, so the
+ * bounce of a release cannot look like a new press.
+ *
+ * =====================================================
+ */
+
+#ifndef DEBOUNCED_IN_H
+#define DEBOUNCED_IN_H
+
+#include "mbed.h"
+
+class DebouncedIn {
+public:
+    DebouncedIn(PinName pin, PinMode mode, std::chrono::microseconds lockout);
+
+    /**
+     * @brief Attaches the handler for debounced falling edges (ISR
+     * context): an active-low input, e.g. a button to ground with a pull-up.
+     */
+    void fall(Callback<void()> handler);
+
+    /**
+     * @brief Attaches the handler for debounced rising edges (ISR
+     * context): an active-high input, e.g. BUTTON1 with its pull-down.
+     */
+    void rise(Callback<void()> handler);
+
+    /**
+     * @brief Changes the lockout window used from the next edge on.
+     */
+    void set_lockout(std::chrono::microseconds lockout);
+
+    /**
+     * @brief Returns the current pin level.
+     */
+    int read() {
+        return in.read();
+    }
+
+private:
+    void onPress();
+    void onRelease();
+    void lock();
+    void unlock();
+
+    InterruptIn in;
+    Timeout lockoutTimer;
+    Callback<void()> handler;
+    std::chrono::microseconds lockout;
+    volatile bool locked = false;
+};
+
+#endif // DEBOUNCED_IN_H
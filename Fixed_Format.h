@@ -0,0 +1,121 @@
+/**
+ * =====================================================
+ * Fixed Format – allocation-free integer text formatting
+ * =====================================================
+ *
+ * Replaces snprintf for the handful of fixed templates this firmware
+ * prints. Appends go straight into a caller-owned char array, the string
+ * is always NUL-terminated, and anything past the end is cut off.
+ *
+ *   FormatBuffer(bufferElapsed).text("The time taken was ").ms<3, 4>(us).text(" ms");
+ *
+ * Field widths and decimal places are template parameters, so every
+ * divisor is a compile-time constant. The compiler turns each division by
+ * ten into a multiply, and no printf, locale or 64-bit division code is
+ * linked in.
+ *
+ * =====================================================
+ */
+
+#ifndef FIXED_FORMAT_H
+#define FIXED_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 10^n at compile time.
+ */
+constexpr uint32_t pow10u(unsigned n) {
+    return (n == 0) ? 1 : 10 * pow10u(n - 1);
+}
+
+class FormatBuffer {
+public:
+    template <size_t N>
+    explicit FormatBuffer(char (&buffer)[N]) : start(buffer), p(buffer), end(buffer + N - 1) {
+        *p = '\0';
+    }
+
+    FormatBuffer(char *buffer, size_t size) : start(buffer), p(buffer), end(buffer + size - 1) {
+        *p = '\0';
+    }
+
+    /**
+     * @brief Appends a string.
+     */
+    FormatBuffer &text(const char *s) {
+        while (*s != '\0' && p < end) {
+            *p++ = *s++;
+        }
+        *p = '\0';
+        return *this;
+    }
+
+    /**
+     * @brief Appends one character.
+     */
+    FormatBuffer &chr(char c) {
+        if (p < end) {
+            *p++ = c;
+        }
+        *p = '\0';
+        return *this;
+    }
+
+    /**
+     * @brief Appends an unsigned integer, right-aligned (space padded) to
+     * Width characters. Width 0 means no padding.
+     */
+    template <unsigned Width = 0>
+    FormatBuffer &uint(uint32_t value) {
+        char digits[10];
+        unsigned n = 0;
+        do {
+            digits[n++] = '0' + value % 10;
+            value /= 10;
+        } while (value != 0);
+
+        for (unsigned pad = n; pad < Width; pad++) {
+            chr(' ');
+        }
+        while (n > 0) {
+            chr(digits[--n]);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Appends a µs value as milliseconds with Decimals places
+     * (truncated), integer part right-aligned to Width characters.
+     * ms<3, 4>(312456) → " 312.456".
+     */
+    template <unsigned Decimals, unsigned Width = 0>
+    FormatBuffer &ms(uint32_t us) {
+        static_assert(Decimals <= 3, "µs resolution gives at most 3 ms decimals");
+
+        uint<Width>(us / 1000);
+        if (Decimals > 0) {
+            uint32_t fraction = (us % 1000) / pow10u(3 - Decimals);
+            chr('.');
+            for (uint32_t digit = pow10u(Decimals) / 10; digit > 0; digit /= 10) {
+                chr('0' + (fraction / digit) % 10);
+            }
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Number of characters written so far.
+     */
+    size_t length() const {
+        return p - start;
+    }
+
+private:
+    char *start;
+    char *p;    // Next free character, always holds '\0'
+    char *end;  // Last usable character (reserved for '\0')
+};
+
+#endif // FIXED_FORMAT_H
@@ -0,0 +1,384 @@
+#include "Flash_Store.h"
+#include "Ring_Buffer.h"
+#include "Trial_Export.h" // crc16()
+
+// Sectors 22 and 23: last 256 KB of bank 2. SNB codes sectors 12–23 as 16–27.
+constexpr uint32_t sectorSize = 128 * 1024;
+constexpr uint32_t sectorBase[2] = { 0x081C0000, 0x081E0000 };
+constexpr uint32_t sectorNumber[2] = { 16 + 10, 16 + 11 };
+
+constexpr uint32_t headerMagic = 0x53505452; // "RTPS"
+constexpr uint32_t headerVersion = 2;
+
+// StoreEntry::type values. A slot that is all 0xFF is free.
+constexpr uint8_t entryProfile = 1;     // ProfileSummary
+constexpr uint8_t entryTrial = 2;
+constexpr uint8_t entryParam = 3;       // profile holds the parameter key
+constexpr uint8_t entryParamClear = 4;
+
+constexpr uint32_t flashErrors = FLASH_SR_PGSERR | FLASH_SR_PGPERR | FLASH_SR_PGAERR |
+                                 FLASH_SR_WRPERR | FLASH_SR_OPERR;
+
+struct StoreHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sequence;   // Higher is newer
+    uint32_t check;      // ~sequence, guards against a half-written header
+};
+
+struct StoreEntry {
+    union {
+        TrialRecord record;       // entryTrial
+        ProfileSummary summary;   // entryProfile
+        uint32_t value;           // entryParam
+    };
+    uint8_t type;         // entryProfile, entryTrial, entryParam, entryParamClear
+    uint8_t profile;      // Or the parameter key
+    uint16_t crc;         // CRC-16 of everything before it
+};
+static_assert(sizeof(StoreHeader) == 16 && sizeof(StoreEntry) == 16, "entries are 4 flash words");
+
+enum class Phase : uint8_t {
+    Ready,     // Appending to the active sector
+    Erasing,   // Spare sector erase in progress
+    Erased,    // Spare sector blank, compaction waits for mayErase
+};
+
+static RingBuffer<StoreEntry, 32> pending; // Deferred thread only
+static ProfileSummary summaries[storeProfiles];
+static uint32_t params[storeParams];
+static uint32_t paramsSet = 0;    // Bit per key with a stored value
+static_assert(storeParams <= 32, "paramsSet has a bit per key");
+constexpr ProfileSummary emptySummary = { UINT32_MAX, 0, 0, 0 };
+static int active = -1;           // Index into sectorBase, -1 if no valid sector
+static uint32_t sequence = 0;     // Of the active sector
+static uint32_t writeAddress = 0; // Next free slot in the active sector
+static Phase phase = Phase::Ready;
+static uint32_t dropped = 0;
+
+// -------------------- Flash Access --------------------
+
+static void flashUnlock() {
+    if (FLASH->CR & FLASH_CR_LOCK) {
+        FLASH->KEYR = 0x45670123;
+        FLASH->KEYR = 0xCDEF89AB;
+    }
+}
+
+static void flashLock() {
+    FLASH->CR |= FLASH_CR_LOCK;
+}
+
+/**
+ * @brief Programs whole words, waiting on each one (~16 µs).
+ */
+static bool flashProgram(uint32_t address, const void *data, uint32_t bytes) {
+    const uint32_t *src = static_cast<const uint32_t *>(data);
+    flashUnlock();
+    FLASH->SR = flashErrors | FLASH_SR_EOP;
+    FLASH->CR = FLASH_CR_PSIZE_1 | FLASH_CR_PG; // 32-bit parallelism
+    for (uint32_t i = 0; i < bytes / 4; i++) {
+        *reinterpret_cast<volatile uint32_t *>(address + 4 * i) = src[i];
+        __DSB();
+        while (FLASH->SR & FLASH_SR_BSY) {
+        }
+    }
+    FLASH->CR &= ~FLASH_CR_PG;
+    bool ok = !(FLASH->SR & flashErrors);
+    flashLock();
+    return ok;
+}
+
+/**
+ * @brief Starts a sector erase and returns at once; poll FLASH_SR_BSY.
+ */
+static void flashEraseStart(uint32_t sector) {
+    flashUnlock();
+    FLASH->SR = flashErrors | FLASH_SR_EOP;
+    FLASH->CR = FLASH_CR_PSIZE_1 | FLASH_CR_SER | (sector << FLASH_CR_SNB_Pos);
+    FLASH->CR |= FLASH_CR_STRT;
+}
+
+/**
+ * @brief Finishes an erase started by flashEraseStart(). The ART data
+ * cache may still hold the old contents, so it is reset.
+ */
+static bool flashEraseFinish() {
+    FLASH->CR &= ~FLASH_CR_SER;
+    bool ok = !(FLASH->SR & flashErrors);
+    flashLock();
+
+    FLASH->ACR &= ~FLASH_ACR_DCEN;
+    FLASH->ACR |= FLASH_ACR_DCRST;
+    FLASH->ACR &= ~FLASH_ACR_DCRST;
+    FLASH->ACR |= FLASH_ACR_DCEN;
+    return ok;
+}
+
+static bool flashBlank(uint32_t address, uint32_t bytes) {
+    const uint32_t *word = reinterpret_cast<const uint32_t *>(address);
+    for (uint32_t i = 0; i < bytes / 4; i++) {
+        if (word[i] != 0xFFFFFFFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// -------------------- Log Format --------------------
+
+static const StoreHeader &headerAt(int s) {
+    return *reinterpret_cast<const StoreHeader *>(sectorBase[s]);
+}
+
+static bool headerValid(int s) {
+    const StoreHeader &h = headerAt(s);
+    return h.magic == headerMagic && h.version == headerVersion && h.check == ~h.sequence;
+}
+
+static uint16_t entryCrc(const StoreEntry &e) {
+    return crc16(reinterpret_cast<const uint8_t *>(&e), offsetof(StoreEntry, crc));
+}
+
+static StoreEntry makeEntry(uint8_t type, uint8_t profile) {
+    StoreEntry e;
+    memset(&e, 0, sizeof(e)); // Padding is covered by the CRC
+    e.type = type;
+    e.profile = profile;
+    return e;
+}
+
+static StoreEntry trialEntry(uint8_t profile, const TrialRecord &record) {
+    StoreEntry e = makeEntry(entryTrial, profile);
+    e.record = record;
+    e.crc = entryCrc(e);
+    return e;
+}
+
+static StoreEntry profileEntry(uint8_t profile, const ProfileSummary &summary) {
+    StoreEntry e = makeEntry(entryProfile, profile);
+    e.summary = summary;
+    e.crc = entryCrc(e);
+    return e;
+}
+
+static StoreEntry paramEntry(uint8_t type, uint8_t key, uint32_t value) {
+    StoreEntry e = makeEntry(type, key);
+    e.value = value;
+    e.crc = entryCrc(e);
+    return e;
+}
+
+static bool entryKeyValid(const StoreEntry &e) {
+    bool param = (e.type == entryParam || e.type == entryParamClear);
+    return e.profile < (param ? storeParams : storeProfiles);
+}
+
+static void applyEntry(const StoreEntry &e) {
+    if (e.type == entryProfile) {
+        summaries[e.profile] = e.summary;
+    } else if (e.type == entryParam) {
+        params[e.profile] = e.value;
+        paramsSet |= 1UL << e.profile;
+    } else if (e.type == entryParamClear) {
+        paramsSet &= ~(1UL << e.profile);
+    }
+}
+
+/**
+ * @brief Iterates the entries of sector s, calling visit for each one
+ * whose CRC checks out. Returns the address of the first free slot.
+ */
+template <typename Visitor>
+static uint32_t scanSector(int s, Visitor visit) {
+    uint32_t address = sectorBase[s] + sizeof(StoreHeader);
+    uint32_t end = sectorBase[s] + sectorSize;
+    for (; address < end; address += sizeof(StoreEntry)) {
+        const StoreEntry &e = *reinterpret_cast<const StoreEntry *>(address);
+        if (flashBlank(address, sizeof(StoreEntry))) {
+            break;
+        }
+        if (e.crc == entryCrc(e) && entryKeyValid(e)) {
+            visit(e); // A torn or corrupt entry is skipped, not fatal
+        }
+    }
+    return address;
+}
+
+static bool append(const StoreEntry &e) {
+    bool ok = flashProgram(writeAddress, &e, sizeof(e));
+    writeAddress += sizeof(e); // A failed slot is never reused
+    return ok;
+}
+
+/**
+ * @brief Copies the live state into the freshly erased spare sector and
+ * makes it the active one by writing its header last.
+ */
+static void compactInto(int spare) {
+    uint32_t oldTrials = 0;
+    if (active >= 0) {
+        scanSector(active, [&](const StoreEntry &e) {
+            oldTrials += (e.type == entryTrial);
+        });
+    }
+
+    int old = active;
+    writeAddress = sectorBase[spare] + sizeof(StoreHeader);
+    for (uint32_t p = 0; p < storeProfiles; p++) {
+        if (summaries[p].count != 0 || summaries[p].best_us != UINT32_MAX) {
+            append(profileEntry(p, summaries[p]));
+        }
+    }
+    for (uint32_t k = 0; k < storeParams; k++) {
+        if (paramsSet & (1UL << k)) {
+            append(paramEntry(entryParam, k, params[k]));
+        }
+    }
+    if (old >= 0) {
+        uint32_t skip = (oldTrials > storeKeptTrials) ? oldTrials - storeKeptTrials : 0;
+        scanSector(old, [&](const StoreEntry &e) {
+            if (e.type != entryTrial) {
+                return;
+            }
+            if (skip > 0) {
+                skip--; // Older than the newest storeKeptTrials
+            } else {
+                append(e);
+            }
+        });
+    }
+
+    StoreHeader h = { headerMagic, headerVersion, sequence + 1, ~(sequence + 1) };
+    flashProgram(sectorBase[spare], &h, sizeof(h));
+    active = spare;
+    sequence++;
+}
+
+// -------------------- Public API --------------------
+
+void storeInit() {
+    for (ProfileSummary &summary : summaries) {
+        summary = emptySummary;
+    }
+    paramsSet = 0;
+
+    active = -1;
+    for (int s = 0; s < 2; s++) {
+        if (headerValid(s) && (active < 0 || headerAt(s).sequence > sequence)) {
+            active = s;
+            sequence = headerAt(s).sequence;
+        }
+    }
+    if (active < 0) {
+        return; // Blank or foreign flash: the first write sets it up
+    }
+    writeAddress = scanSector(active, &applyEntry);
+}
+
+const ProfileSummary &storeProfile(uint8_t profile) {
+    return (profile < storeProfiles) ? summaries[profile] : emptySummary;
+}
+
+void storeRecordProfile(uint8_t profile, const ProfileSummary &summary) {
+    if (profile >= storeProfiles) {
+        return;
+    }
+    summaries[profile] = summary;
+    if (!pending.push(profileEntry(profile, summary))) {
+        dropped++;
+    }
+}
+
+bool storeParam(uint8_t key, uint32_t &value) {
+    if (key >= storeParams || !(paramsSet & (1UL << key))) {
+        return false;
+    }
+    value = params[key];
+    return true;
+}
+
+void storeRecordParam(uint8_t key, uint32_t value) {
+    if (key >= storeParams) {
+        return;
+    }
+    StoreEntry e = paramEntry(entryParam, key, value);
+    applyEntry(e);
+    if (!pending.push(e)) {
+        dropped++;
+    }
+}
+
+void storeClearParam(uint8_t key) {
+    if (key >= storeParams) {
+        return;
+    }
+    StoreEntry e = paramEntry(entryParamClear, key, 0);
+    applyEntry(e);
+    if (!pending.push(e)) {
+        dropped++;
+    }
+}
+
+void storeRecordTrial(uint8_t profile, const TrialRecord &record) {
+    if (profile >= storeProfiles || !pending.push(trialEntry(profile, record))) {
+        dropped++;
+    }
+}
+
+bool storeService(bool mayErase) {
+    int spare = (active == 0) ? 1 : 0;
+
+    if (phase == Phase::Erasing) {
+        if (FLASH->SR & FLASH_SR_BSY) {
+            return true; // Come back later instead of stalling the thread
+        }
+        phase = Phase::Ready;
+        if (!flashEraseFinish()) {
+            return true; // Retry the erase next time
+        }
+        phase = Phase::Erased;
+    }
+    if (phase == Phase::Erased) {
+        if (!mayErase) {
+            return true; // Compaction programs hundreds of words back to back
+        }
+        phase = Phase::Ready;
+        compactInto(spare);
+    }
+
+    StoreEntry e;
+    while (!pending.empty()) {
+        bool full = active < 0 || writeAddress + sizeof(StoreEntry) > sectorBase[active] + sectorSize;
+        if (full) {
+            if (!mayErase) {
+                return true;
+            }
+            if (!flashBlank(sectorBase[spare], sectorSize)) {
+                flashEraseStart(sectorNumber[spare]);
+                phase = Phase::Erasing;
+                return true;
+            }
+            compactInto(spare); // Already blank (first use): no erase needed
+            continue;
+        }
+        pending.pop(e);
+        append(e);
+    }
+    return false;
+}
+
+void storeForEachTrial(void (*visit)(uint8_t profile, const TrialRecord &record)) {
+    if (active < 0) {
+        return;
+    }
+    scanSector(active, [&](const StoreEntry &e) {
+        if (e.type == entryTrial) {
+            visit(e.profile, e.record);
+        }
+    });
+}
+
+uint32_t storeDropped() {
+    return dropped;
+}
@@ -0,0 +1,141 @@
+/**
+ * =====================================================
+ * Flash Store – persistent profile results and trial history
+ * =====================================================
+ *
+ * Keeps each profile's summary (personal best, trial count and sum), the
+ * run-time parameters set over the serial port (Run_Config) and a
+ * compact log of past trials in the last two 128 KB sectors of the F429's
+ * flash (sectors 22 and 23, bank 2), so they survive power cycles and
+ * resets.
+ *
+ * Log structure: the active sector is an append-only list of 16-byte
+ * entries behind a header carrying a sequence number. An updated summary
+ * or parameter is just another entry; the last one per profile or
+ * parameter wins (a "clear" entry reverts a parameter), so nothing is
+ * rewritten in place and a trial costs one 16-byte program, not an erase.
+ * When the active sector fills up, the other sector is erased, the live
+ * state (every profile's summary, every set parameter and the newest
+ * storeKeptTrials trials) is
+ * copied into it, and its header is written last with the next sequence
+ * number. The two sectors take turns, so erases are spread evenly; a reset
+ * part-way through leaves the old sector in charge.
+ *
+ * Timing: writes are queued in RAM and performed by storeService() on the
+ * deferred thread, never in an ISR. Bank 2 supports read-while-write, so
+ * neither programming nor an erase stalls code running from bank 1; on
+ * top of that the caller only lets an erase start outside a reaction
+ * window, and while one runs storeService() returns instead of spinning.
+ * The compaction that follows programs word by word with a BSY wait each,
+ * so it is held back the same way until mayErase is true again.
+ *
+ * The application image must stay below 0x081C0000 (1.75 MB).
+ *
+ * =====================================================
+ */
+
+#ifndef FLASH_STORE_H
+#define FLASH_STORE_H
+
+#include "Trial_Record.h"
+#include "mbed.h"
+
+constexpr uint32_t storeProfiles = 8;       // Profiles with a stored summary
+constexpr uint32_t storeKeptTrials = 512;   // Trials carried over on compaction
+constexpr uint32_t storeParams = 32;        // Run-time parameter slots, by key
+
+/**
+ * Running results of one profile. The mean comes from an exact 40-bit sum
+ * (a running mean updated with integer division drifts toward zero and
+ * stops moving once count outgrows the deviations); packed with a 24-bit
+ * count, the summary still fits the 12 bytes of a log entry.
+ */
+struct ProfileSummary {
+    uint32_t best_us;        // Personal best, UINT32_MAX if none
+    uint32_t count : 24;     // Valid trials so far
+    uint32_t sumHigh : 8;    // Bits 32–39 of the sum of those trials (µs)
+    uint32_t sumLow_us;      // Bits 0–31
+
+    uint64_t sum_us() const {
+        return (uint64_t)sumHigh << 32 | sumLow_us;
+    }
+
+    /**
+     * @brief Mean of the valid trials, rounded; 0 if there are none.
+     */
+    uint32_t mean_us() const {
+        return (count > 0) ? (uint32_t)((sum_us() + count / 2) / count) : 0;
+    }
+
+    /**
+     * @brief Folds in one valid trial. Saturates (stops counting) at 2^24
+     * trials or 2^40 µs, far beyond any one person's use.
+     */
+    void add(uint32_t us) {
+        uint64_t sum = sum_us() + us;
+        if (count == 0xFFFFFF || sum >> 40) {
+            return;
+        }
+        count++;
+        sumHigh = (uint32_t)(sum >> 32);
+        sumLow_us = (uint32_t)sum;
+    }
+};
+
+/**
+ * @brief Finds the newest valid sector and rebuilds the profile summaries
+ * from it. Only reads flash; call once at boot, before storeService().
+ */
+void storeInit();
+
+/**
+ * @brief Stored summary of profile; an empty one if it has none yet.
+ */
+const ProfileSummary &storeProfile(uint8_t profile);
+
+/**
+ * @brief Queues an updated summary for profile.
+ */
+void storeRecordProfile(uint8_t profile, const ProfileSummary &summary);
+
+/**
+ * @brief Queues a trial for the history log.
+ */
+void storeRecordTrial(uint8_t profile, const TrialRecord &record);
+
+/**
+ * @brief Stored value of parameter key.
+ * @return false if none is set (the built-in default applies).
+ */
+bool storeParam(uint8_t key, uint32_t &value);
+
+/**
+ * @brief Queues a new value for parameter key.
+ */
+void storeRecordParam(uint8_t key, uint32_t value);
+
+/**
+ * @brief Queues the removal of parameter key's value, back to its default.
+ */
+void storeClearParam(uint8_t key);
+
+/**
+ * @brief Writes queued entries to flash. If the active sector is full it
+ * compacts into the other one, but only starts the erase, or the copy
+ * once it has finished, when mayErase is true. Thread context only.
+ * @return true while work remains (queued entries or an erase in
+ * progress); call again later.
+ */
+bool storeService(bool mayErase);
+
+/**
+ * @brief Calls visit for every stored trial, oldest first.
+ */
+void storeForEachTrial(void (*visit)(uint8_t profile, const TrialRecord &record));
+
+/**
+ * @brief Entries lost because the write queue was full.
+ */
+uint32_t storeDropped();
+
+#endif // FLASH_STORE_H
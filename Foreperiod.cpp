@@ -0,0 +1,44 @@
+#include "Foreperiod.h"
+
+/**
+ * @brief Returns one 32-bit word from the hardware RNG. On a seed or clock
+ * error the peripheral is restarted, as the reference manual requires.
+ */
+static uint32_t rngRead() {
+    while (!(RNG->SR & RNG_SR_DRDY)) {
+        if (RNG->SR & (RNG_SR_SECS | RNG_SR_CECS)) {
+            RNG->SR = 0;
+            RNG->CR &= ~RNG_CR_RNGEN;
+            RNG->CR |= RNG_CR_RNGEN;
+        }
+    }
+    return RNG->DR;
+}
+
+void foreperiodInit() {
+    RCC->AHB2ENR |= RCC_AHB2ENR_RNGEN;
+    (void)RCC->AHB2ENR; // Let the clock enable settle
+    RNG->CR |= RNG_CR_RNGEN;
+}
+
+uint32_t foreperiodNext(const ForeperiodConfig &config) {
+    uint32_t span = config.max_us - config.min_us;
+    uint32_t r = rngRead();
+
+    if (config.distribution == ForeperiodDistribution::Exponential && config.mean_us > 0) {
+        // Inverse CDF of an exponential truncated to [0, span]:
+        //   x = -mean * ln(1 - u * (1 - e^(-span / mean)))
+        float u = (r >> 8) * (1.0f / 16777216.0f); // 24 random bits → [0, 1)
+        float tail = 1.0f - expf(-(float)span / config.mean_us);
+        float x = -(float)config.mean_us * logf(1.0f - u * tail);
+        uint32_t offset = (x < (float)span) ? (uint32_t)x : span;
+        return config.min_us + offset;
+    }
+
+    // Uniform: scale the 32-bit word onto [0, span] without division
+    return config.min_us + (uint32_t)(((uint64_t)r * ((uint64_t)span + 1)) >> 32);
+}
+
+uint32_t foreperiodRandom(uint32_t n) {
+    return (uint32_t)(((uint64_t)rngRead() * n) >> 32);
+}
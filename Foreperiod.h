@@ -0,0 +1,56 @@
+/**
+ * =====================================================
+ * Foreperiod – random delay before the stimulus
+ * =====================================================
+ *
+ * Draws the LED-off delay between the start press and the stimulus from
+ * the STM32F429's hardware RNG. The RNG delivers a fresh 32-bit word every
+ * 40 RNG clock cycles, so there is no PRNG state to seed and a value is
+ * practically always waiting by the time the next trial starts.
+ *
+ * Distributions:
+ *   Uniform     – flat between min and max. Simple, but the hazard rate
+ *                 rises over time, so late stimuli become predictable.
+ *   Exponential – truncated exponential ("non-aging") starting at min. The
+ *                 chance of the stimulus arriving in the next instant stays
+ *                 almost constant, so subjects cannot anticipate it.
+ *
+ * =====================================================
+ */
+
+#ifndef FOREPERIOD_H
+#define FOREPERIOD_H
+
+#include "mbed.h"
+
+enum class ForeperiodDistribution : uint8_t {
+    Uniform,
+    Exponential,
+};
+
+struct ForeperiodConfig {
+    ForeperiodDistribution distribution;
+    uint32_t min_us;   // Shortest foreperiod
+    uint32_t max_us;   // Longest foreperiod
+    uint32_t mean_us;  // Exponential only: mean of the part above min_us
+};
+
+/**
+ * @brief Enables the RNG peripheral (needs the 48 MHz PLL48CLK, which Mbed
+ * already sets up for USB on this target).
+ */
+void foreperiodInit();
+
+/**
+ * @brief Returns the next foreperiod in microseconds, in [min_us, max_us].
+ * Safe to call from interrupt context.
+ */
+uint32_t foreperiodNext(const ForeperiodConfig &config);
+
+/**
+ * @brief Returns a uniform random integer in [0, n) from the same RNG,
+ * e.g. the stimulus of a choice-reaction trial. Interrupt safe.
+ */
+uint32_t foreperiodRandom(uint32_t n);
+
+#endif // FOREPERIOD_H
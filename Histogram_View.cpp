@@ -0,0 +1,109 @@
+#include "Histogram_View.h"
+
+constexpr uint16_t left = 1;          // 17 columns of 14 px across 240
+constexpr uint16_t pitch = 14;
+constexpr uint16_t barWidth = 12;
+constexpr uint16_t plotHeight = 56;   // Rows above the axis
+constexpr uint32_t markerHeight = 2;  // CDF step thickness
+constexpr uint16_t tickHeight = 4;
+constexpr uint32_t tickEvery = 4;     // Bins: 200 ms
+static_assert(left + HistogramView::columns * pitch <= 240, "histogram wider than the panel");
+static_assert(plotHeight + 1 + tickHeight <= HistogramView::height, "histogram taller than its area");
+
+HistogramView::HistogramView(uint16_t y) : y(y) {
+    invalidate();
+}
+
+void HistogramView::place(uint16_t y) {
+    this->y = y;
+}
+
+void HistogramView::init(uint32_t barColor, uint32_t fastColor, uint32_t curveColor, uint32_t bg) {
+    this->barColor = barColor;
+    this->fastColor = fastColor;
+    this->curveColor = curveColor;
+    this->bg = bg;
+}
+
+void HistogramView::invalidate() {
+    axisShown = false;
+    for (uint32_t i = 0; i < columns; i++) {
+        shownBar[i] = 0;
+        shownCurve[i] = noCurve;
+    }
+}
+
+uint32_t HistogramView::rowColor(uint32_t column, uint32_t row, uint8_t bar, uint8_t curve) const {
+    if (curve != noCurve && row >= curve && row < curve + markerHeight) {
+        return curveColor;
+    }
+    if (row < bar) {
+        return (column == 0) ? fastColor : barColor;
+    }
+    return bg;
+}
+
+/**
+ * @brief Fills the runs of rows whose colour differs between what the
+ * column shows and (bar, curve). Rows count up from the axis.
+ */
+void HistogramView::drawColumn(uint32_t column, uint8_t bar, uint8_t curve) {
+    if (bar == shownBar[column] && curve == shownCurve[column]) {
+        return;
+    }
+    uint16_t x = left + column * pitch;
+    uint16_t axis = y + plotHeight;
+    uint32_t row = 0;
+    while (row < plotHeight) {
+        uint32_t color = rowColor(column, row, bar, curve);
+        if (color == rowColor(column, row, shownBar[column], shownCurve[column])) {
+            row++;
+            continue;
+        }
+        uint32_t end = row + 1;
+        while (end < plotHeight && rowColor(column, end, bar, curve) == color &&
+               rowColor(column, end, shownBar[column], shownCurve[column]) != color) {
+            end++;
+        }
+        rendererFillRect(x, axis - end, barWidth, end - row, color);
+        row = end;
+    }
+    shownBar[column] = bar;
+    shownCurve[column] = curve;
+}
+
+void HistogramView::drawAxis() {
+    uint16_t axis = y + plotHeight;
+    rendererFillRect(0, axis, 240, 1, barColor);
+    // Ticks at the left edge of every tickEvery-th bin (0, 200, 400 ... ms)
+    for (uint32_t bin = 0; bin < SessionStats::binCount; bin += tickEvery) {
+        rendererFillRect(left + (bin + 1) * pitch - 1, axis + 1, 1, tickHeight, barColor);
+    }
+    axisShown = true;
+}
+
+void HistogramView::draw(const uint16_t (&bins)[SessionStats::binCount], uint16_t fast) {
+    if (!axisShown) {
+        drawAxis();
+    }
+
+    uint32_t fullest = fast;
+    uint32_t total = 0;
+    for (uint16_t count : bins) {
+        fullest = (count > fullest) ? count : fullest;
+        total += count;
+    }
+
+    // Any trial at all shows at least one pixel row
+    auto barHeight = [&](uint32_t count) -> uint8_t {
+        return (count == 0) ? 0 : (uint8_t)((count * plotHeight + fullest - 1) / fullest);
+    };
+
+    drawColumn(0, barHeight(fast), noCurve);
+    uint32_t cumulative = 0;
+    for (uint32_t bin = 0; bin < SessionStats::binCount; bin++) {
+        cumulative += bins[bin];
+        uint8_t curve = (total == 0) ? noCurve : (uint8_t)(cumulative * (plotHeight - markerHeight) / total);
+        drawColumn(bin + 1, barHeight(bins[bin]), curve);
+    }
+}
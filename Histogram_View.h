@@ -0,0 +1,79 @@
+/**
+ * =====================================================
+ * Histogram View – session histogram and CDF on the LCD
+ * =====================================================
+ *
+ * Draws the session's fixed-bin histogram (SessionStats::bins, 50 ms per
+ * bin) as bars across the bottom of the panel, with the cumulative
+ * distribution as a step curve over them. A column on the left, in its
+ * own colour, counts the trials thrown out as too fast (anticipations and
+ * early presses), so a subject guessing the stimulus stands out at once;
+ * a tail growing to the right over a session shows fatigue.
+ *
+ *    #           ---- --   CDF steps
+ *    #        --  _
+ *    #      __ _ | |_
+ *    #     | || || | |_
+ *   -+-----+---+---+---+--   ticks every 200 ms
+ *   fast  0   200 400 600
+ *
+ * Bars scale to the fullest column. Each column keeps the bar height and
+ * curve row it has on screen; an update fills only the pixel runs whose
+ * colour changes, with DMA2D rectangle fills, so a trial typically
+ * touches a few small runs per column instead of the whole chart.
+ *
+ * Display thread only.
+ *
+ * =====================================================
+ */
+
+#ifndef HISTOGRAM_VIEW_H
+#define HISTOGRAM_VIEW_H
+
+#include "Lcd_Renderer.h"
+#include "Session_Stats.h"
+
+class HistogramView {
+public:
+    static constexpr uint32_t columns = SessionStats::binCount + 1; // Column 0: rejected as too fast
+    static constexpr uint16_t height = 64;                          // Plot, axis and ticks
+
+    explicit HistogramView(uint16_t y);
+
+    /**
+     * @brief Moves the chart's top edge to y (run-time layout). Call
+     * before init().
+     */
+    void place(uint16_t y);
+
+    void init(uint32_t barColor, uint32_t fastColor, uint32_t curveColor, uint32_t bg);
+
+    /**
+     * @brief Brings the chart up to date with bins (valid trials) and
+     * fast (anticipations and early presses this session).
+     */
+    void draw(const uint16_t (&bins)[SessionStats::binCount], uint16_t fast);
+
+    /**
+     * @brief Forgets the screen contents after the area was wiped to bg.
+     */
+    void invalidate();
+
+private:
+    static constexpr uint8_t noCurve = 0xFF;
+
+    uint32_t rowColor(uint32_t column, uint32_t row, uint8_t bar, uint8_t curve) const;
+    void drawColumn(uint32_t column, uint8_t bar, uint8_t curve);
+    void drawAxis();
+
+    uint16_t y;
+    uint32_t barColor = 0;
+    uint32_t fastColor = 0;
+    uint32_t curveColor = 0;
+    uint32_t bg = 0;
+    bool axisShown = false;
+    uint8_t shownBar[columns];    // Bar height on screen, px
+    uint8_t shownCurve[columns];  // CDF row on screen (px above the axis), or noCurve
+};
+
+#endif // HISTOGRAM_VIEW_H
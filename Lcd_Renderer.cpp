@@ -0,0 +1,441 @@
+#include "Lcd_Renderer.h"
+#include "stm32f429i_discovery_sdram.h"
+
+constexpr uint32_t screenWidth = 240;
+constexpr uint32_t screenHeight = 320;
+constexpr uint32_t frameBytes = screenWidth * screenHeight * 4;
+
+// Two framebuffers, both clear of the address range the BSP layers use
+constexpr uint32_t frameA = LCD_FRAME_BUFFER;
+constexpr uint32_t frameB = LCD_FRAME_BUFFER + BUFFER_OFFSET;
+static_assert(BUFFER_OFFSET >= frameBytes, "framebuffers overlap");
+
+// Printable ASCII, one A8 cell per glyph, packed with no padding
+constexpr char firstGlyph = ' ';
+constexpr char lastGlyph = '~';
+constexpr uint32_t glyphCount = lastGlyph - firstGlyph + 1;
+constexpr uint32_t maxGlyphBytes = 17 * 24; // Largest BSP font (Font24)
+
+// SDRAM after frameB: the glyph atlas, then the bitmap cache
+constexpr uint32_t atlasBase = LCD_FRAME_BUFFER + 2 * BUFFER_OFFSET;
+constexpr uint32_t cacheBase = atlasBase + glyphCount * maxGlyphBytes;
+constexpr uint32_t cacheEnd = LCD_FRAME_BUFFER + 0x200000; // Trial log may follow
+
+// DMA2D modes (CR MODE)
+constexpr uint32_t dma2dMemToMem = 0UL << DMA2D_CR_MODE_Pos;
+constexpr uint32_t dma2dBlend = 2UL << DMA2D_CR_MODE_Pos;
+constexpr uint32_t dma2dFill = 3UL << DMA2D_CR_MODE_Pos;
+// DMA2D colour modes (xxPFCCR CM)
+constexpr uint32_t cmArgb8888 = 0;
+constexpr uint32_t cmA8 = 9;
+
+constexpr uint32_t flagDma2dDone = 1UL << 0;
+constexpr uint32_t flagReloaded = 1UL << 1;
+
+// Dirty rectangles drawn into the back buffer since the last present()
+struct Rect {
+    uint16_t x, y, w, h;
+};
+constexpr uint32_t maxDirty = 32;
+
+static uint8_t *const atlas = reinterpret_cast<uint8_t *>(atlasBase);
+static uint32_t cacheNext = cacheBase;
+static uint16_t glyphW = 0;
+static uint16_t glyphH = 0;
+static uint32_t front = frameA;  // Scanned out by the LTDC
+static uint32_t back = frameB;   // Being drawn into
+static Rect dirty[maxDirty];
+static uint32_t dirtyCount = 0;
+static bool dirtyAll = false;    // List overflowed: copy the whole frame
+static EventFlags rendererFlags;
+static LCD_DISCO_F429ZI *panel = nullptr;
+static volatile bool swapRequested = false; // present() waits for the next reload
+static volatile uint32_t overlayLine = 0;   // LIPCR of an overlay latched at the next reload, 0 if none
+static void (*volatile scanHook)() = nullptr;
+
+// -------------------- Interrupts --------------------
+
+static void dma2dIrq() {
+    DMA2D->IFCR = DMA2D_IFCR_CTCIF | DMA2D_IFCR_CTEIF;
+    rendererFlags.set(flagDma2dDone);
+}
+
+static void ltdcIrq() {
+    uint32_t status = LTDC->ISR;
+    if (status & LTDC_ISR_LIF) {
+        // Scanout has reached the first row of a newly shown overlay
+        LTDC->ICR = LTDC_ICR_CLIF;
+        LTDC->IER &= ~LTDC_IER_LIE;
+        void (*hook)() = scanHook;
+        if (hook != nullptr) {
+            hook();
+        }
+    }
+    if (status & LTDC_ISR_RRIF) {
+        LTDC->ICR = LTDC_ICR_CRRIF;
+        if (overlayLine != 0) {
+            // The overlay was latched at this blanking: watch for its first line
+            LTDC->LIPCR = overlayLine;
+            LTDC->ICR = LTDC_ICR_CLIF;
+            LTDC->IER |= LTDC_IER_LIE;
+            overlayLine = 0;
+        }
+        // Reloads also come from rendererOverlay(); only one requested after
+        // present() wrote the address has swapped the frame
+        if (swapRequested) {
+            swapRequested = false;
+            rendererFlags.set(flagReloaded);
+        }
+    }
+}
+
+// -------------------- DMA2D helpers --------------------
+
+/**
+ * @brief Waits for the previous transfer by polling. Used between small
+ * transfers (single glyphs), which finish in well under a microsecond.
+ */
+static void dma2dSpin() {
+    while (DMA2D->CR & DMA2D_CR_START) {
+    }
+}
+
+/**
+ * @brief Waits for a long transfer, sleeping on its completion interrupt.
+ */
+static void dma2dWait() {
+    if (DMA2D->CR & DMA2D_CR_START) {
+        rendererFlags.wait_any(flagDma2dDone);
+    }
+    rendererFlags.clear(flagDma2dDone);
+}
+
+static void dma2dStart(uint32_t mode, bool interrupt) {
+    rendererFlags.clear(flagDma2dDone);
+    DMA2D->CR = mode | (interrupt ? (DMA2D_CR_TCIE | DMA2D_CR_TEIE) : 0) | DMA2D_CR_START;
+}
+
+static uint32_t pixelAddress(uint32_t base, uint32_t stride, uint16_t x, uint16_t y) {
+    return base + (y * stride + x) * 4;
+}
+
+static void fill(uint32_t base, uint32_t stride, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                 uint32_t color, bool interrupt) {
+    dma2dSpin();
+    DMA2D->OPFCCR = cmArgb8888;
+    DMA2D->OCOLR = color;
+    DMA2D->OMAR = pixelAddress(base, stride, x, y);
+    DMA2D->OOR = stride - w;
+    DMA2D->NLR = ((uint32_t)w << 16) | h;
+    dma2dStart(dma2dFill, interrupt);
+}
+
+/**
+ * @brief Copies a w×h ARGB8888 block between two surfaces.
+ */
+static void copy(uint32_t src, uint32_t srcStride, uint32_t dst, uint32_t dstStride, uint16_t w,
+                 uint16_t h, bool interrupt) {
+    dma2dSpin();
+    DMA2D->FGMAR = src;
+    DMA2D->FGOR = srcStride - w;
+    DMA2D->FGPFCCR = cmArgb8888;
+    DMA2D->OPFCCR = cmArgb8888;
+    DMA2D->OMAR = dst;
+    DMA2D->OOR = dstStride - w;
+    DMA2D->NLR = ((uint32_t)w << 16) | h;
+    dma2dStart(dma2dMemToMem, interrupt);
+}
+
+/**
+ * @brief Blends one glyph mask in fg onto the cell at (x, y) of a surface.
+ * The cell must already hold its background.
+ */
+static void blendGlyph(uint32_t base, uint32_t stride, uint16_t x, uint16_t y, char c, uint32_t fg) {
+    if (c < firstGlyph || c > lastGlyph) {
+        c = '?';
+    }
+    uint32_t cell = pixelAddress(base, stride, x, y);
+
+    dma2dSpin();
+    DMA2D->FGMAR = (uint32_t)(atlas + (c - firstGlyph) * glyphW * glyphH);
+    DMA2D->FGOR = 0;
+    DMA2D->FGPFCCR = cmA8;
+    DMA2D->FGCOLR = fg & 0x00FFFFFF;
+    DMA2D->BGMAR = cell;
+    DMA2D->BGOR = stride - glyphW;
+    DMA2D->BGPFCCR = cmArgb8888;
+    DMA2D->OPFCCR = cmArgb8888;
+    DMA2D->OMAR = cell;
+    DMA2D->OOR = stride - glyphW;
+    DMA2D->NLR = ((uint32_t)glyphW << 16) | glyphH;
+    dma2dStart(dma2dBlend, false);
+}
+
+// -------------------- Dirty rectangles --------------------
+
+/**
+ * @brief Records an area of the back buffer as changed this frame. A
+ * rectangle on the same text row as the previous one is merged into it,
+ * and so is one in the same column (chart bars); copying the few
+ * unchanged pixels in between is cheaper than another transfer.
+ */
+static void markDirty(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    if (dirtyAll) {
+        return;
+    }
+    if (dirtyCount > 0) {
+        Rect &last = dirty[dirtyCount - 1];
+        if (last.y == y && last.h == h) {
+            uint16_t start = (x < last.x) ? x : last.x;
+            uint16_t end = (x + w > last.x + last.w) ? x + w : last.x + last.w;
+            last.x = start;
+            last.w = end - start;
+            return;
+        }
+        if (last.x == x && last.w == w) {
+            uint16_t start = (y < last.y) ? y : last.y;
+            uint16_t end = (y + h > last.y + last.h) ? y + h : last.y + last.h;
+            last.y = start;
+            last.h = end - start;
+            return;
+        }
+    }
+    if (dirtyCount == maxDirty) {
+        dirtyAll = true;
+        return;
+    }
+    dirty[dirtyCount++] = {x, y, w, h};
+}
+
+// -------------------- Public API --------------------
+
+void rendererInit(LCD_DISCO_F429ZI &lcd, sFONT *font) {
+    panel = &lcd;
+    glyphW = font->Width;
+    glyphH = font->Height;
+    MBED_ASSERT((uint32_t)glyphW * glyphH <= maxGlyphBytes);
+
+    // Expand the 1-bpp BSP font (MSB first, rows padded to whole bytes)
+    // into one 8-bit alpha byte per pixel
+    uint32_t rowBytes = (glyphW + 7) / 8;
+    for (uint32_t g = 0; g < glyphCount; g++) {
+        const uint8_t *src = font->table + g * glyphH * rowBytes;
+        uint8_t *dst = atlas + g * glyphW * glyphH;
+        for (uint32_t row = 0; row < glyphH; row++) {
+            uint32_t bits = 0;
+            for (uint32_t b = 0; b < rowBytes; b++) {
+                bits = (bits << 8) | src[row * rowBytes + b];
+            }
+            for (uint32_t col = 0; col < glyphW; col++) {
+                bool on = bits & (1UL << (rowBytes * 8 - 1 - col));
+                dst[row * glyphW + col] = on ? 0xFF : 0x00;
+            }
+        }
+    }
+
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA2DEN;
+    (void)RCC->AHB1ENR; // Let the clock enable settle
+    NVIC_SetVector(DMA2D_IRQn, (uint32_t)&dma2dIrq);
+    NVIC_EnableIRQ(DMA2D_IRQn);
+    NVIC_SetVector(LTDC_IRQn, (uint32_t)&ltdcIrq);
+    NVIC_EnableIRQ(LTDC_IRQn);
+
+    // Background layer shows frameA; the foreground layer is the overlay,
+    // off until rendererOverlay() gives it a bitmap and a window
+    lcd.LayerDefaultInit(LCD_BACKGROUND_LAYER, frameA);
+    lcd.LayerDefaultInit(LCD_FOREGROUND_LAYER, frameB);
+    lcd.SetLayerVisible(LCD_BACKGROUND_LAYER, 1);
+    lcd.SetLayerVisible(LCD_FOREGROUND_LAYER, 0);
+    LTDC->IER |= LTDC_IER_RRIE;
+
+    fill(frameA, screenWidth, 0, 0, screenWidth, screenHeight, LCD_COLOR_WHITE, true);
+    dma2dWait();
+    fill(frameB, screenWidth, 0, 0, screenWidth, screenHeight, LCD_COLOR_WHITE, true);
+    dma2dWait();
+}
+
+void rendererClear(uint32_t color) {
+    fill(back, screenWidth, 0, 0, screenWidth, screenHeight, color, true);
+    dma2dWait();
+    dirtyAll = true;
+}
+
+void rendererFillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t color) {
+    if (x >= screenWidth || y >= screenHeight || w == 0 || h == 0) {
+        return;
+    }
+    if (x + w > screenWidth) {
+        w = screenWidth - x;
+    }
+    if (y + h > screenHeight) {
+        h = screenHeight - y;
+    }
+    fill(back, screenWidth, x, y, w, h, color, false);
+    markDirty(x, y, w, h);
+}
+
+uint16_t rendererText(uint16_t x, uint16_t y, const char *text, uint32_t fg, uint32_t bg) {
+    if (y + glyphH > screenHeight || x >= screenWidth) {
+        return x;
+    }
+
+    // One fill for the background of the whole (clipped) string
+    uint32_t fit = (screenWidth - x) / glyphW;
+    uint32_t length = strnlen(text, fit);
+    if (length == 0) {
+        return x;
+    }
+    fill(back, screenWidth, x, y, length * glyphW, glyphH, bg, false);
+    markDirty(x, y, length * glyphW, glyphH);
+
+    for (uint32_t i = 0; i < length; i++, x += glyphW) {
+        blendGlyph(back, screenWidth, x, y, text[i], fg);
+    }
+    return x;
+}
+
+void rendererGlyph(uint16_t x, uint16_t y, char c, uint32_t fg, uint32_t bg) {
+    if (x + glyphW > screenWidth || y + glyphH > screenHeight) {
+        return;
+    }
+    fill(back, screenWidth, x, y, glyphW, glyphH, bg, false);
+    if (c != ' ') {
+        blendGlyph(back, screenWidth, x, y, c, fg);
+    }
+    markDirty(x, y, glyphW, glyphH);
+}
+
+RendererBitmap rendererRenderText(const char *text, uint32_t fg, uint32_t bg) {
+    uint16_t w = strnlen(text, screenWidth / glyphW) * glyphW;
+    uint32_t bytes = (uint32_t)w * glyphH * 4;
+    if (w == 0 || cacheNext + bytes > cacheEnd) {
+        return {0, 0, 0};
+    }
+    RendererBitmap bitmap = {cacheNext, w, glyphH};
+    cacheNext += bytes;
+
+    fill(bitmap.address, w, 0, 0, w, glyphH, bg, false);
+    for (uint16_t x = 0; *text != '\0' && x < w; text++, x += glyphW) {
+        blendGlyph(bitmap.address, w, x, 0, *text, fg);
+    }
+    return bitmap;
+}
+
+RendererBitmap rendererRenderFill(uint16_t w, uint16_t h, uint32_t color) {
+    uint32_t bytes = (uint32_t)w * h * 4;
+    if (w == 0 || h == 0 || w > screenWidth || h > screenHeight || cacheNext + bytes > cacheEnd) {
+        return {0, 0, 0};
+    }
+    RendererBitmap bitmap = {cacheNext, w, h};
+    cacheNext += bytes;
+
+    fill(bitmap.address, w, 0, 0, w, h, color, true);
+    dma2dWait();
+    return bitmap;
+}
+
+void rendererBlit(const RendererBitmap &bitmap, uint16_t x, uint16_t y) {
+    if (bitmap.address == 0 || x + bitmap.width > screenWidth || y + bitmap.height > screenHeight) {
+        return;
+    }
+    copy(bitmap.address, bitmap.width, pixelAddress(back, screenWidth, x, y), screenWidth,
+         bitmap.width, bitmap.height, false);
+    markDirty(x, y, bitmap.width, bitmap.height);
+}
+
+void rendererPresent() {
+    if (!dirtyAll && dirtyCount == 0) {
+        return; // Nothing drawn, nothing to show
+    }
+    dma2dSpin(); // Last glyph or fill must land before the swap
+
+    // Latch the new address at the next vertical blanking, sleep until then
+    rendererFlags.clear(flagReloaded);
+    LTDC_Layer1->CFBAR = back;
+    swapRequested = true; // Any reload from here on carries the new address
+    LTDC->SRCR = LTDC_SRCR_VBR;
+    rendererFlags.wait_any(flagReloaded);
+
+    uint32_t shown = back;
+    back = front;
+    front = shown;
+
+    // Bring the new back buffer up to date with what is on screen, copying
+    // only what changed this frame
+    if (dirtyAll) {
+        copy(front, screenWidth, back, screenWidth, screenWidth, screenHeight, true);
+        dma2dWait();
+    } else {
+        for (uint32_t i = 0; i < dirtyCount; i++) {
+            const Rect &r = dirty[i];
+            copy(pixelAddress(front, screenWidth, r.x, r.y), screenWidth,
+                 pixelAddress(back, screenWidth, r.x, r.y), screenWidth, r.w, r.h, false);
+        }
+        dma2dSpin();
+    }
+    dirtyCount = 0;
+    dirtyAll = false;
+}
+
+/**
+ * @brief Issues an FMC command to the SDRAM bank behind the framebuffers.
+ */
+static void sdramCommand(uint32_t mode) {
+    FMC_SDRAM_CommandTypeDef command = {};
+    command.CommandMode = mode;
+    command.CommandTarget = FMC_SDRAM_CMD_TARGET_BANK2;
+    command.AutoRefreshNumber = 1;
+    BSP_SDRAM_Sendcmd(&command);
+}
+
+void rendererOverlay(const RendererBitmap *bitmap, uint16_t x, uint16_t y) {
+    if (bitmap == nullptr || bitmap->address == 0 || x + bitmap->width > screenWidth ||
+        y + bitmap->height > screenHeight) {
+        LTDC_Layer2->CR &= ~LTDC_LxCR_LEN;
+        LTDC->IER &= ~LTDC_IER_LIE; // No report for an overlay that is gone
+        overlayLine = 0;
+    } else {
+        // Window coordinates count from the end of the back porches
+        uint32_t ahbp = (LTDC->BPCR & LTDC_BPCR_AHBP) >> LTDC_BPCR_AHBP_Pos;
+        uint32_t avbp = LTDC->BPCR & LTDC_BPCR_AVBP;
+        uint32_t top = avbp + 1 + y;
+        LTDC_Layer2->WHPCR = ((ahbp + x + bitmap->width) << LTDC_LxWHPCR_WHSPPOS_Pos) | (ahbp + 1 + x);
+        LTDC_Layer2->WVPCR = ((top + bitmap->height - 1) << LTDC_LxWVPCR_WVSPPOS_Pos) | top;
+        LTDC_Layer2->CFBAR = bitmap->address;
+        LTDC_Layer2->CFBLR = ((uint32_t)bitmap->width * 4 << LTDC_LxCFBLR_CFBP_Pos) | (bitmap->width * 4 + 3);
+        LTDC_Layer2->CFBLNR = bitmap->height;
+        LTDC_Layer2->CR |= LTDC_LxCR_LEN;
+        overlayLine = top;
+    }
+    LTDC->SRCR = LTDC_SRCR_VBR;
+}
+
+void rendererOnOverlayScan(void (*hook)()) {
+    scanHook = hook;
+}
+
+void rendererSuspend() {
+    dma2dSpin(); // No transfer may be in flight when SDRAM stops
+    panel->DisplayOff();
+    LTDC->GCR &= ~LTDC_GCR_LTDCEN; // Stop scanning out of SDRAM
+    sdramCommand(FMC_SDRAM_CMD_SELFREFRESH_MODE);
+}
+
+void rendererResume() {
+    sdramCommand(FMC_SDRAM_CMD_NORMAL_MODE);
+    // STOP mode switched PLLSAI (the pixel clock) off, and Mbed's wake-up
+    // only restarts the main PLL
+    RCC->CR |= RCC_CR_PLLSAION;
+    while (!(RCC->CR & RCC_CR_PLLSAIRDY)) {
+    }
+    LTDC->GCR |= LTDC_GCR_LTDCEN;
+    panel->DisplayOn();
+}
+
+uint16_t rendererGlyphWidth() {
+    return glyphW;
+}
+
+uint16_t rendererGlyphHeight() {
+    return glyphH;
+}
@@ -0,0 +1,144 @@
+/**
+ * =====================================================
+ * LCD Renderer – double-buffered drawing with DMA2D
+ * =====================================================
+ *
+ * Two ARGB8888 framebuffers in SDRAM alternate behind the LTDC background
+ * layer. Everything is drawn into the hidden (back) buffer; present()
+ * hands it to the LTDC with a vertical-blanking reload, so the panel never
+ * shows a half-drawn frame.
+ *
+ * The foreground layer is an overlay: one pre-rendered bitmap in a window
+ * above the frame. Showing or hiding it is a few shadow-register writes,
+ * allowed from interrupt context, with no drawing or present() in the
+ * way, and it takes effect at the next vertical blanking. The LTDC line
+ * interrupt then reports the moment scanout reaches its first row, so a
+ * stimulus drawn there is timed to within one line (~50 µs) instead of a
+ * frame.
+ *
+ * Pixel work is done by the DMA2D (Chrom-ART) engine:
+ *   - fills are register-to-memory transfers,
+ *   - text is blended glyph by glyph from an A8 atlas (built once from the
+ *     BSP font) onto the background, with the text colour in FGCOLR,
+ *   - cached bitmaps (pre-rendered text) are memory-to-memory copies.
+ *
+ * Dirty rectangles: every draw call records the area it touched. After a
+ * swap only those rectangles are copied from the new front buffer to the
+ * new back buffer, so both stay identical at a cost proportional to what
+ * changed. Successive cells on one row, or fills in one column, merge
+ * into a single rectangle; if the list overflows, the whole frame is
+ * copied.
+ *
+ * Long transfers block the caller on an interrupt-driven flag, so the
+ * CPU is free in the meantime.
+ *
+ * Only the display thread may call these functions, except
+ * rendererOverlay().
+ *
+ * =====================================================
+ */
+
+#ifndef LCD_RENDERER_H
+#define LCD_RENDERER_H
+
+#include "LCD_DISCO_F429ZI.h"
+#include "mbed.h"
+
+/**
+ * An off-screen ARGB8888 image in SDRAM, e.g. a pre-rendered label.
+ */
+struct RendererBitmap {
+    uint32_t address;  // 0 if allocation failed
+    uint16_t width;
+    uint16_t height;
+};
+
+/**
+ * @brief Takes over both LTDC layers from the BSP and builds the glyph
+ * atlas for font: the background layer shows the double-buffered UI
+ * frames, cleared to white, and the foreground layer becomes the stimulus
+ * overlay, hidden until rendererOverlay(). Call once, after the LCD
+ * constructor has run.
+ */
+void rendererInit(LCD_DISCO_F429ZI &lcd, sFONT *font);
+
+/**
+ * @brief Fills the whole back buffer with color.
+ */
+void rendererClear(uint32_t color);
+
+/**
+ * @brief Fills a rectangle of the back buffer with color.
+ */
+void rendererFillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t color);
+
+/**
+ * @brief Draws text at (x, y), glyph cells filled with bg first.
+ * Text running past the right edge is clipped. Returns the x after the
+ * last glyph.
+ */
+uint16_t rendererText(uint16_t x, uint16_t y, const char *text, uint32_t fg, uint32_t bg);
+
+/**
+ * @brief Draws a single glyph cell at (x, y).
+ */
+void rendererGlyph(uint16_t x, uint16_t y, char c, uint32_t fg, uint32_t bg);
+
+/**
+ * @brief Renders text once into a new off-screen bitmap. Bitmaps are
+ * carved from a fixed SDRAM region and never freed; create them at init.
+ */
+RendererBitmap rendererRenderText(const char *text, uint32_t fg, uint32_t bg);
+
+/**
+ * @brief Creates an off-screen bitmap filled with color, e.g. an overlay.
+ * Same allocation rules as rendererRenderText().
+ */
+RendererBitmap rendererRenderFill(uint16_t w, uint16_t h, uint32_t color);
+
+/**
+ * @brief Copies a bitmap into the back buffer at (x, y).
+ */
+void rendererBlit(const RendererBitmap &bitmap, uint16_t x, uint16_t y);
+
+/**
+ * @brief Shows the back buffer at the next vertical blanking and waits for
+ * the swap. Returns once drawing into the new back buffer is safe.
+ */
+void rendererPresent();
+
+/**
+ * @brief Shows bitmap on the overlay layer at (x, y) from the next frame
+ * on, or hides the overlay if bitmap is nullptr. It must fit on screen.
+ * Safe from interrupt context; the bitmap must stay valid while shown.
+ */
+void rendererOverlay(const RendererBitmap *bitmap, uint16_t x, uint16_t y);
+
+/**
+ * @brief Registers a function called from the LTDC line interrupt when
+ * scanout reaches the first row of a newly shown overlay, i.e. the moment
+ * it starts to be driven onto the panel. nullptr removes it.
+ */
+void rendererOnOverlayScan(void (*hook)());
+
+/**
+ * @brief Turns the panel and the LTDC off and puts the SDRAM into
+ * self-refresh, so nothing keeps the bus or the PLLs busy and the MCU can
+ * enter STOP mode. Framebuffer contents survive; no other renderer call is
+ * allowed until rendererResume().
+ */
+void rendererSuspend();
+
+/**
+ * @brief Undoes rendererSuspend(): SDRAM back to normal mode, LTDC and
+ * panel back on, showing the same frame as before.
+ */
+void rendererResume();
+
+/**
+ * @brief Font cell size, in pixels.
+ */
+uint16_t rendererGlyphWidth();
+uint16_t rendererGlyphHeight();
+
+#endif // LCD_RENDERER_H
@@ -0,0 +1,84 @@
+/**
+ * =====================================================
+ * Leaderboard – top-K personal bests across profiles
+ * =====================================================
+ *
+ * A sorted fixed array of at most K rows, fastest first, one row per
+ * profile. A new personal best moves its profile's row up by shifting the
+ * rows it overtakes, so an update costs O(K) with K a small constant, and
+ * the display reads the ranking as is instead of sorting anything.
+ *
+ * All values are in microseconds.
+ *
+ * =====================================================
+ */
+
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <stdint.h>
+
+template <uint32_t K>
+class Leaderboard {
+public:
+    struct Row {
+        uint32_t best_us;
+        uint8_t profile;
+    };
+
+    /**
+     * @brief Removes all rows.
+     */
+    void clear() {
+        count = 0;
+    }
+
+    /**
+     * @brief Records a new best for profile, replacing its previous row.
+     * Does nothing if the board is full and best_us would not place.
+     */
+    void update(uint8_t profile, uint32_t best_us) {
+        remove(profile);
+        if (count == K && best_us >= rows[K - 1].best_us) {
+            return;
+        }
+        uint32_t i = (count < K) ? count++ : K - 1; // Full: the slowest row drops off
+        for (; i > 0 && rows[i - 1].best_us > best_us; i--) {
+            rows[i] = rows[i - 1];
+        }
+        rows[i] = { best_us, profile };
+    }
+
+    /**
+     * @brief Removes profile's row, if it has one.
+     */
+    void remove(uint8_t profile) {
+        uint32_t i = 0;
+        while (i < count && rows[i].profile != profile) {
+            i++;
+        }
+        if (i == count) {
+            return;
+        }
+        for (count--; i < count; i++) {
+            rows[i] = rows[i + 1];
+        }
+    }
+
+    uint32_t size() const {
+        return count;
+    }
+
+    /**
+     * @brief Row at rank (0 = fastest), rank < size().
+     */
+    const Row &operator[](uint32_t rank) const {
+        return rows[rank];
+    }
+
+private:
+    Row rows[K];
+    uint32_t count = 0;
+};
+
+#endif // LEADERBOARD_H
@@ -0,0 +1,71 @@
+#include "Led_Blinker.h"
+
+// TIM8_UP request: DMA2 Stream 1, channel 7
+constexpr uint32_t blinkChannel = 7;
+constexpr uint32_t blinkFlags = DMA_LIFCR_CTCIF1 | DMA_LIFCR_CHTIF1 | DMA_LIFCR_CTEIF1 |
+                                DMA_LIFCR_CDMEIF1 | DMA_LIFCR_CFEIF1;
+constexpr uint32_t tickHz = 10000; // TIM8 counts at 10 kHz
+
+static uint32_t pattern[2];        // BSRR words: set pin, reset pin
+static uint32_t blinkingPin = 0;   // BSRR reset word of the current pin, 0 if none
+
+/**
+ * @brief Returns the TIM8 input clock. APB2 timers run at twice PCLK2
+ * whenever the APB2 prescaler is not 1.
+ */
+static uint32_t timer8Clock() {
+    uint32_t pclk2 = HAL_RCC_GetPCLK2Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE2) != RCC_CFGR_PPRE2_DIV1) {
+        return pclk2 * 2;
+    }
+    return pclk2;
+}
+
+void ledBlinkInit() {
+    RCC->APB2ENR |= RCC_APB2ENR_TIM8EN;
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
+    (void)RCC->APB2ENR; // Let the clock enable settle
+
+    TIM8->CR1 = TIM_CR1_URS; // Only overflows raise update requests
+    TIM8->PSC = timer8Clock() / tickHz - 1;
+
+    DMA2_Stream1->CR = 0;
+    DMA2_Stream1->PAR = (uint32_t)&GPIOG->BSRR;
+    DMA2_Stream1->M0AR = (uint32_t)pattern;
+}
+
+void ledBlinkStart(uint32_t pin, std::chrono::milliseconds halfPeriod) {
+    ledBlinkStop();
+
+    pattern[0] = 1UL << pin;          // Set: LED on
+    pattern[1] = 1UL << (pin + 16);   // Reset: LED off
+    blinkingPin = pattern[1];
+    sleep_manager_lock_deep_sleep(); // TIM8 and DMA halt in STOP mode
+
+    DMA2->LIFCR = blinkFlags;
+    DMA2_Stream1->NDTR = 2;
+    DMA2_Stream1->CR = (blinkChannel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_DIR_0 | DMA_SxCR_MINC |
+                       DMA_SxCR_CIRC | DMA_SxCR_PSIZE_1 | DMA_SxCR_MSIZE_1;
+    DMA2_Stream1->CR |= DMA_SxCR_EN;
+
+    TIM8->ARR = halfPeriod.count() * (tickHz / 1000) - 1;
+    TIM8->CNT = 0;
+    TIM8->EGR = TIM_EGR_UG;     // Load PSC/ARR; URS keeps this from toggling
+    TIM8->SR = 0;
+    TIM8->DIER = TIM_DIER_UDE;
+    TIM8->CR1 |= TIM_CR1_CEN;
+}
+
+void ledBlinkStop() {
+    TIM8->CR1 &= ~TIM_CR1_CEN;
+    TIM8->DIER = 0;
+    DMA2_Stream1->CR &= ~DMA_SxCR_EN;
+    while (DMA2_Stream1->CR & DMA_SxCR_EN) {
+        // Disabling takes effect after any in-flight transfer
+    }
+    if (blinkingPin != 0) {
+        GPIOG->BSRR = blinkingPin; // Leave the LED off
+        blinkingPin = 0;
+        sleep_manager_unlock_deep_sleep();
+    }
+}
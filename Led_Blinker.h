@@ -0,0 +1,41 @@
+/**
+ * =====================================================
+ * LED Blinker – CPU-free LED blinking with TIM8 + DMA
+ * =====================================================
+ *
+ * The onboard LEDs (PG13, PG14) have no timer output function, so they
+ * are toggled by DMA instead: every TIM8 update event makes DMA2 Stream 1
+ * (channel 7, TIM8_UP) write the next word of a two-entry circular table
+ * into GPIOG->BSRR, alternately setting and resetting the pin.
+ *
+ * Once started, blinking needs no interrupts and no CPU at all, so the
+ * core can stay in sleep mode between button presses. Timer and DMA halt
+ * in STOP mode, so a running blink holds the deep-sleep lock; stopping it
+ * releases the lock again.
+ *
+ * =====================================================
+ */
+
+#ifndef LED_BLINKER_H
+#define LED_BLINKER_H
+
+#include "mbed.h"
+
+/**
+ * @brief Enables the TIM8 and DMA2 clocks and configures the stream.
+ */
+void ledBlinkInit();
+
+/**
+ * @brief Blinks one GPIOG pin, toggling every halfPeriod. Replaces any
+ * blink in progress (whose pin is left off).
+ * @param pin GPIOG pin number, e.g. 13 for PG13.
+ */
+void ledBlinkStart(uint32_t pin, std::chrono::milliseconds halfPeriod);
+
+/**
+ * @brief Stops blinking and turns the pin that was blinking off.
+ */
+void ledBlinkStop();
+
+#endif // LED_BLINKER_H
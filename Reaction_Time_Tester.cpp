@@ -6,8 +6,10 @@
  * States:
  *
  *   [Idle / Ready]
- *       - Green LED blinks at ~10Hz
+ *       - Green LED blinks at ~10Hz (TIM8 + DMA, no CPU)
  *       - Waits for onboard button press
+ *       - External button → next user profile
+ *       - No press for dormantAfter → Dormant
  *                |
  *                v
  *   [Random Delay / Reaction Prep]
@@ -18,188 +20,1596 @@
  *                v
  *   [Reaction Measurement]
  *       - Wait for user button press
- *       - If pressed too early → reset to Idle
+ *       - If pressed too early → logged as an early trial, not counted
  *       - If valid press:
  *            * Measure reaction time
  *            * Update personal best if faster
  *                |
  *                v
+ *   [Trial Result]
+ *       - Red LED on, LCD shows the result and session statistics
+ *       - Onboard button → next trial (back to Random Delay)
+ *       - After sessionTrials trials → Test Complete
+ *                |
+ *                v
  *   [Test Complete]
  *       - Red LED blinks every 300ms
  *       - LCD displays:
  *            * Latest reaction time
  *            * Fastest reaction time
- *       - Onboard button → restart
+ *       - Onboard button → leaderboard
  *       - External button → reset everything
  *                |
  *                v
+ *   [Leaderboard]
+ *       - Fastest personal bests across all profiles
+ *       - Onboard button → restart
+ *                |
+ *                v
  *   [Reset State]
- *       - Triggered by external button (PA6)
- *       - Clears LCD, resets fastest time
+ *       - Triggered by external button (PA6) outside Idle
+ *       - Clears LCD, resets the profile's fastest time
  *       - Returns to Idle
  *
+ *   [Dormant]
+ *       - Entered from Idle, Test Complete or Leaderboard after dormantAfter
+ *       - LEDs and LCD off, SDRAM in self-refresh, MCU in STOP mode
+ *       - Any button press (EXTI) wakes it back to Idle
+ *
+ * Choice reaction (choiceStimuli > 1): each trial shows one of several
+ * stimuli from stimulusTable (green LED, red LED, on-screen targets), and
+ * the response must be the input listed next to it. The external button
+ * is then a response key during the foreperiod and reaction; between
+ * trials it does nothing, and it only resets from Idle, Test Complete or
+ * the Leaderboard.
+ *
+ * Calibration: hold the external button while powering up (PB3 jumpered
+ * to PA0). The FSM then runs calibrationTrials synthetic trials and the
+ * measured path latency is subtracted from later BUTTON1 results. It is
+ * stored as the cal_offset_us parameter and loaded again at every boot.
+ *
+ * All transitions live in fsmTable (State x Event → next state + action).
+ *
  * =====================================================
  */
 
+#include "Calibration.h"      // Measurement-chain latency self-test
+#include "Capture_Timer.h"    // TIM2 hardware timestamping
+#include "Cycle_Profiler.h"   // DWT cycle-count probes
+#include "Debounced_In.h"     // Button edge lockout
+#include "Fixed_Format.h"     // printf-free result formatting
+#include "Flash_Store.h"      // Persistent personal bests and history
+#include "Foreperiod.h"       // Hardware-RNG random foreperiod
+#include "Histogram_View.h"   // Session histogram and CDF chart
+#include "Led_Blinker.h"      // TIM8 + DMA LED blinking
 #include "LCD_DISCO_F429ZI.h" // LCD driver library
+#include "Lcd_Renderer.h"     // Double-buffered DMA2D drawing
+#include "Leaderboard.h"      // Top-K personal bests
+#include "Ring_Buffer.h"      // Lock-free SPSC FIFO
+#include "Run_Config.h"       // Run-time parameters stored in flash
+#include "Seq_Lock.h"         // Tear-free snapshot for the display thread
+#include "Session_Stats.h"    // Streaming per-session statistics
+#include "Text_Line.h"        // Cell-diffed LCD text rows
+#include "Time_Base.h"        // TIM2 disciplined against the LSE/RTC
+#include "Touch_Input.h"      // STMPE811 touchscreen responses
+#include "Trial_Export.h"     // DMA UART export of trial records
+#include "Trial_Record.h"     // Raw per-trial data
+#include "Trial_Validation.h" // Anticipation, lapse and outlier checks
+#include "Unit_Link.h"        // RS-485 multi-unit aggregation
 #include "mbed.h"             // Mbed OS hardware abstraction library
+#include <atomic>
+#include <new>
+
+// -------------------- Build Options --------------------
+// HW_CAPTURE 1: press time is latched by TIM2 input capture on the button
+//               pin, stimulus time is read from TIM2 when green goes high.
+// HW_CAPTURE 0: fall back to the Mbed Timer, read inside user().
+// Both modes report microseconds.
+#ifndef HW_CAPTURE
+#define HW_CAPTURE 1
+#endif
+
+// TRIAL_LOG_SDRAM 1: keep the trial log in the Discovery board's SDRAM
+//                    (2 MB in, clear of both LCD layers) instead of SRAM.
+#ifndef TRIAL_LOG_SDRAM
+#define TRIAL_LOG_SDRAM 0
+#endif
+
+// Random delay between the start press and the stimulus.
+// Switch to ForeperiodDistribution::Exponential for a non-aging foreperiod.
+constexpr ForeperiodConfig foreperiodConfig = {
+    ForeperiodDistribution::Uniform,
+    1000000,   // min 1 s
+    5000000,   // max 5 s
+    1500000,   // exponential mean above min
+};
+
+// Stimuli per trial. 1 is simple reaction (green LED, onboard button).
+// 2–4 is choice reaction: each trial shows one of the first choiceStimuli
+// rows of stimulusTable at random, and expects the response in that row.
+// Rows 3 and 4 are screen targets answered by touch; the touchscreen and
+// BUTTON1 are both brought up whenever a row in use expects them.
+constexpr uint32_t choiceStimuli = 1;
+constexpr bool choiceMode = choiceStimuli > 1;
+
+// Simple reaction stimulus: the green LED, or (true) a target in the
+// middle of the LCD. Screen targets are pre-rendered on the LTDC overlay
+// layer and timed from the scanout of their first line.
+constexpr bool screenStimulus = false;
+
+// Trials run back to back per session. 1 gives the classic single test.
+constexpr uint32_t sessionTrials = 20;
+
+// Rapid-fire training: each trial starts on its own after a short random
+// inter-trial interval instead of a press, and a finished session returns
+// straight to Idle without the red blink. A press between trials restarts
+// the interval.
+constexpr bool rapidFire = false;
+constexpr ForeperiodConfig interTrialConfig = {
+    ForeperiodDistribution::Uniform,
+    300000,    // min 300 ms
+    1500000,   // max 1.5 s
+    0,
+};
+
+// Checks after capture. Trials that fail are logged but kept out of the
+// personal best and statistics.
+constexpr ValidationConfig validationConfig = {
+    100000,    // Anticipation below 100 ms
+    1000000,   // Lapse above 1 s
+    3.5f,      // Outlier beyond 3.5 robust SDs from the session median
+    5,         // ... once 5 trials are in
+};
+
+// Fatigue trend: mean, lapses and drift over the last trendTrials trials
+// (a power of two), with lapses counted the PVT way
+constexpr uint32_t trendTrials = 32;
+constexpr uint32_t trendLapse_us = 500000;  // Slower than 500 ms, or past the ceiling
+
+// User profiles, cycled with the external button while idle, and the
+// number of them ranked on the leaderboard
+constexpr uint8_t profileCount = 4;
+constexpr uint32_t leaderboardRows = 5;
+static_assert(profileCount <= storeProfiles, "profile has no flash slot");
+static_assert(leaderboardRows == configBoardRows, "Run_Config checks the layout of configBoardRows rows");
+
+// Trial records buffered between the press ISR and the deferred thread.
+// Must be a power of two.
+constexpr uint32_t trialLogCapacity = 64;
+
+// Response input. CaptureInput::Touch: subjects tap the screen instead of
+// pressing BUTTON1, timestamped on the touch controller's INT line. Falls
+// back to the button if no touch controller answers.
+constexpr CaptureInput responseInput = CaptureInput::Button;
+
+// Button debouncing: edges within the lockout window after the first one
+// are ignored. The capture filter rejects glitches on PA0 in hardware.
+constexpr auto userLockout = 20ms;
+constexpr auto externalLockout = 50ms;
+constexpr uint8_t captureGlitchFilter = 15; // TIM2 IC1F: ~2.8 µs
+
+// Time without a press in Idle, Complete or Leaderboard before the unit goes Dormant
+constexpr auto dormantAfter = 60s;
+
+// Flash store retry interval while an erase runs or must wait
+constexpr auto storeRetry = 50ms;
+
+// TIM2/RTC pairing for drift correction and wall-clock trial stamps
+// (paused while Dormant, when TIM2 stops)
+constexpr auto timebaseInterval = 10s;
+
+// Trial export over the ST-LINK virtual COM port
+constexpr ExportConfig exportConfig = {
+    ExportFormat::Binary,     // ExportFormat::Csv for a readable terminal log
+    ExportMode::Continuous,   // ExportMode::SessionEnd to batch per session
+    115200,
+};
+
+// Multi-unit aggregation on an RS-485 bus (UART5, DE/RE on PC11). Give
+// every unit its own id from 1 to units; one board is the Collector and
+// merges all units' trials per profile ('N' on its VCP dumps them).
+constexpr LinkConfig linkConfig = {
+    LinkRole::Off,            // LinkRole::Unit or LinkRole::Collector on a bus
+    1,                        // This unit's id
+    8,                        // Units on the bus
+    1000000,                  // 1 Mbaud: linkSlot_us is sized for it
+    PC_11,
+    50ms,                     // Beacon period
+};
+static_assert(linkConfig.units <= linkMaxUnits, "more units than slots");
+static_assert(linkGap_us + linkConfig.units * linkSlot_us + 1000 <= 1000 * linkConfig.cycle.count(),
+              "unit slots and the beacon do not fit in the cycle");
+
+// Run-time parameters. The values above are the defaults; any set over
+// the VCP ('C' commands, see Run_Config.h) override them from the next
+// boot. Everything reads the loaded copy, `config`.
+constexpr RunConfig defaultConfig = {
+    sessionTrials,
+    foreperiodConfig,
+    validationConfig,
+    100,      // Idle: green toggles every 100 ms
+    300,      // Test complete: red toggles every 300 ms
+    12,       // Font12
+    { 20, 40, 80, 100, 116, 132, 150, 16, 254, 60 }, // Profile, result and leaderboard rows, histogram, trend
+    0,        // Calibration offset: none until the self-test has run
+};
+static_assert(sessionTrials <= configMaxTrials, "sessionTrials above the run-time limit");
 
 // -------------------- Hardware Setup --------------------
-LCD_DISCO_F429ZI LCD;                   // LCD display object
-InterruptIn userButton(BUTTON1);        // Onboard user button (blue button)
-InterruptIn external_button(PA_6, PullUp); // External pushbutton with internal pull-up
+/**
+ * @brief The LCD, constructed on first use. Its constructor brings up the
+ * SDRAM, the LTDC and the ILI9341, which takes longer than the whole rest
+ * of boot, so main() first starts the FSM and only then calls this.
+ */
+LCD_DISCO_F429ZI &lcd() {
+    static LCD_DISCO_F429ZI instance;
+    return instance;
+}
+
+DebouncedIn userButton(BUTTON1, PullNone, userLockout);       // Onboard user button (blue button)
+DebouncedIn external_button(PA_6, PullUp, externalLockout);  // External pushbutton with internal pull-up
+TouchInput touchscreen(PA_15, PC_9, PA_8);  // STMPE811: INT, I2C3 SDA, SCL
 DigitalOut green(PG_13);                // Onboard green LED
 DigitalOut red(PG_14);                  // Onboard red LED
-Ticker ticker;                          // Periodic timer (not actively used in this version)
-Timeout timeout;                        // Timeout for scheduling events
+Timeout timeout;                        // Schedules the stimulus, or in rapid-fire the next trial
+LowPowerTimeout inactivity;             // Counts down to Dormant, runs in STOP mode
 Timer t;                                // Timer for reaction time measurement
 
+// -------------------- Deferred Work --------------------
+// ISRs only capture timestamps and drive the LEDs; anything slow (formatting,
+// personal-best bookkeeping) is posted here and runs in thread context.
+EventQueue deferredQueue(16 * EVENTS_EVENT_SIZE);
+Thread deferredThread(osPriorityAboveNormal, 2048, nullptr, "deferred");
+
+// -------------------- Trial Log --------------------
+// Written by the press ISR, drained by deferredThread. No heap, no locks.
+struct LoggedTrial {
+    TrialRecord record;
+    uint32_t stamp;     // TIM2 count of the stimulus onset (the press, if there was none)
+};
+using TrialLog = RingBuffer<LoggedTrial, trialLogCapacity>;
+#if TRIAL_LOG_SDRAM
+// SDRAM comes up with the LCD, so this build constructs the LCD at static
+// init, ahead of the log, and gives up the early start.
+TrialLog &trialLog = *new ((lcd(), reinterpret_cast<void *>(0xD0200000))) TrialLog();
+#else
+TrialLog trialLog;
+#endif
+uint32_t trialLogDropped = 0; // Records lost because the log was full
+
+// -------------------- FSM States and Events --------------------
+enum class State : uint8_t {
+    Idle,         // Green LED blinking, waiting for a start press
+    Foreperiod,   // LED off for the random delay
+    Reaction,     // LED on, waiting for the reaction press
+    TrialResult,  // Result (or early press) shown, red LED on, press for the next trial
+                  // (rapid-fire: LED off, next trial after the interval)
+    Complete,     // Session finished, red LED blinking
+    Leaderboard,  // Top profiles shown, red LED blinking
+    Dormant,      // Display and LEDs off, MCU in STOP mode until a press
+    Count
+};
+
+enum class Event : uint8_t {
+    UserPress,      // Onboard button (user() ISR)
+    ExternalPress,  // External reset button (external() ISR)
+    Stimulus,       // Foreperiod elapsed (timeout)
+    SessionEnd,     // Last trial of the session captured (internal)
+    Inactivity,     // No press for dormantAfter (inactivity timeout)
+    Interval,       // Inter-trial interval elapsed, rapid-fire only (timeout)
+    Count
+};
+
+// Input a press came from. Choice reaction compares it with the stimulus.
+enum class Response : uint8_t {
+    UserButton,       // BUTTON1
+    ExternalButton,   // PA6
+    TouchLeft,        // Tap on the left half of the screen
+    TouchRight,       // Tap on the right half
+    Touch,            // Tap, half not known until the position is read
+};
+
 // -------------------- Global Variables --------------------
-int state = 0;                // Finite State Machine (FSM) state
-bool reaction = false;        // Flag: true when waiting for a reaction
-int pB = INT_MAX;             // Personal best reaction time (initialized to max value)
-uint64_t elapsed = 0;         // Elapsed reaction time (ms)
-char bufferElapsed[32];       // Buffer for latest reaction time string
-char bufferpB[32];            // Buffer for personal best string
+std::atomic<State> state{State::Idle}; // FSM state; written by dispatch() only, read by both threads
+uint32_t pB = UINT32_MAX;     // Personal best reaction time in µs (initialized to max value)
+uint32_t onset = 0;           // TIM2 timestamp of the stimulus appearing
+volatile bool onsetValid = false; // onset is set (screen stimuli: first line scanned out)
+uint32_t foreperiod = 0;      // Current trial's random delay (µs)
+uint32_t trial = 0;           // Trials captured in the current session
+RunConfig config = defaultConfig; // Loaded from flash once in main(), then read-only
+uint32_t sessionLength = sessionTrials; // Trials in the current session
+uint8_t profile = 0;          // User profile the results are stored under
+CaptureInput responseSource = CaptureInput::Button; // Input actually timed
+uint8_t stimulus = 0;         // Row of stimulusTable shown this trial
+Response response = Response::UserButton; // Input of the latest press
+uint32_t pressTime = 0;       // TIM2 count at ISR entry, for inputs without capture
+SessionStats sessionStats;    // Running stats, updated on deferredThread only
+MedianWindow<configMaxTrials> sessionWindow; // The session's trials for the outlier check, same thread
+TrendWindow<trendTrials> trend; // Fatigue metrics, same thread
+uint64_t trendOrigin = 0;     // Wall time (µs) of the session's first trend trial, 0 before it
+Leaderboard<leaderboardRows> leaderboard; // Updated on deferredThread only
+SessionStats stimulusStats[4]; // Choice reaction: correct responses per stimulus
+uint32_t choiceAnswered = 0;  // Choice reaction: responses this session
+uint32_t choiceCorrect = 0;   // ... of which matched the stimulus
+int timebaseEvent = 0;        // deferredQueue id of the periodic timebaseSample()
+SessionStats networkStats[linkMaxUnits + 1][profileCount]; // Collector: valid trials per unit (0: itself) and profile
+
+// Text of every result line. deferredThread formats into its own copy,
+// `results`, and publishes it whole; the main thread draws from the latest
+// published copy. A redraw therefore never mixes a new latest time with an
+// old best, and neither side ever masks interrupts.
+struct DisplaySnapshot {
+    char elapsed[32];         // Latest reaction time
+    char pB[32];              // Personal best
+    char stats[32];           // Trial count and mean
+    char spread[32];          // SD, min and max
+    char profile[32];         // Profile, trial count and mean
+    char board[leaderboardRows + 1][32]; // Leaderboard title and rows
+    char choice[32];          // Accuracy and per-stimulus means
+    uint16_t bins[SessionStats::binCount]; // Session histogram of valid trials
+    uint16_t fast;            // Anticipations and early presses this session
+    char trend[32];           // Rolling fatigue metrics, or the session's at the end
+};
+DisplaySnapshot results;      // Working copy, deferredThread only
+SeqLock<DisplaySnapshot> published; // Latest complete copy
+
+// -------------------- Display Update Flags --------------------
+// Posted by the FSM whenever a result line changes. The main thread sleeps on
+// these and redraws only the lines whose flag is set.
+constexpr uint32_t DISPLAY_ELAPSED = 1UL << 0;   // Latest time text changed
+constexpr uint32_t DISPLAY_PB      = 1UL << 1;   // Personal best text changed
+constexpr uint32_t DISPLAY_CLEAR   = 1UL << 2;   // Wipe the screen first
+constexpr uint32_t DISPLAY_STATS   = 1UL << 3;   // Stats/spread text changed
+constexpr uint32_t DISPLAY_POWER   = 1UL << 4;   // Entered or left Dormant
+constexpr uint32_t DISPLAY_PROFILE = 1UL << 5;   // Profile text changed
+constexpr uint32_t DISPLAY_BOARD   = 1UL << 6;   // Leaderboard text changed
+constexpr uint32_t DISPLAY_CHOICE  = 1UL << 7;   // Choice text changed
+constexpr uint32_t DISPLAY_HISTOGRAM = 1UL << 8; // Histogram counts changed
+constexpr uint32_t DISPLAY_TREND   = 1UL << 9;   // Trend text changed
+constexpr uint32_t DISPLAY_ALL     = DISPLAY_ELAPSED | DISPLAY_PB | DISPLAY_CLEAR | DISPLAY_STATS |
+                                     DISPLAY_POWER | DISPLAY_PROFILE | DISPLAY_BOARD | DISPLAY_CHOICE |
+                                     DISPLAY_HISTOGRAM | DISPLAY_TREND;
+EventFlags displayFlags;      // Set from ISRs, waited on by the main thread
 
 // -------------------- Function Declarations --------------------
+void blinkGreen(); // Green LED blinking while idle
 void blinkRed();   // Red LED blinking after test completion
-void reaction1();  // Start reaction phase
-void tick();       // FSM tick handler
+void reaction1();  // Foreperiod elapsed: raise the stimulus event
+void inactive();   // Inactivity timeout: raise the inactivity event
+void interval();   // Inter-trial interval timeout: raise the interval event
 void user();       // Onboard user button ISR
 void external();   // External reset button ISR
+void touched();    // Touchscreen tap ISR
+void command(char c); // Serial command byte ISR
+void drainTrials();             // Deferred: process records from the trial log
+void recordResult(TrialRecord record, uint32_t stamp); // Deferred: format result, update personal best
+void resetResults();            // Deferred: clear personal best and LCD text
+void resetSession();            // Deferred: clear session statistics
+void finishSession();           // Deferred: flush the session's export batch
+void formatProfile();           // Deferred: format the selected profile's line
+void recordChoice(const TrialRecord &record); // Deferred: choice accuracy and per-stimulus means
+void recordTrend(const TrialRecord &record, uint64_t wall); // Deferred: fold a trial into the fatigue window
+void rebuildLeaderboard();      // Deferred: rank all stored personal bests
+void persist();                 // Deferred: write queued results to flash
+void publish(uint32_t changed); // Deferred: publish results, redraw the changed lines
+void dumpProfile();             // Deferred: send the cycle profile over the VCP
+void showProfile();             // Deferred: load and show the selected profile
+void showLeaderboard();         // Deferred: format the leaderboard rows
+void hideLeaderboard();         // Deferred: blank the leaderboard rows
+void startTimebase();           // Deferred: first TIM2/RTC pair, then sample periodically
+void restartTimebase();         // Deferred: new window after STOP mode, sampling again
+void mergeTrial(uint8_t unit, const LinkTrial &trial); // Deferred: fold a bus trial into networkStats
+void dumpNetwork();             // Deferred: send the merged per-unit, per-profile stats over the VCP
+struct ConfigLine {
+    char text[40];
+};
+void configure(ConfigLine line); // Deferred: run a 'C' command
+
+template <Event E> void dispatch(); // Fire event E (see fsmTable)
+
+// -------------------- Stimulus/Response Table --------------------
+// Called from interrupt context. LED stimuli stamp their onset as they
+// switch on. Screen targets are bitmaps rendered at startup and put on
+// the LTDC overlay layer, so showing one draws nothing; their onset is
+// stamped by the LTDC line interrupt when scanout reaches their first
+// row (see targetOnScreen()).
+
+struct ScreenTarget {
+    uint16_t x, y, w, h;
+    uint32_t color;
+};
+
+constexpr ScreenTarget screenTargets[] = {
+    { 10, 250, 100, 60, LCD_COLOR_BLUE },     // Left: choice reaction, tap the left half
+    { 130, 250, 100, 60, LCD_COLOR_MAGENTA }, // Right: tap the right half
+    { 70, 250, 100, 60, LCD_COLOR_GREEN },    // Centre: simple reaction (screenStimulus)
+};
+constexpr uint32_t screenTargetCount = sizeof(screenTargets) / sizeof(screenTargets[0]);
+RendererBitmap targetBitmaps[screenTargetCount]; // Rendered by startDisplay()
+
+void showGreen() {
+    green = 1;
+    onset = captureTimerNow(); // Right after the edge
+    onsetValid = true;
+}
+
+void hideGreen() {
+    green = 0;
+}
 
-// -------------------- FSM Functions --------------------
+void showRed() {
+    red = 1;
+    onset = captureTimerNow();
+    onsetValid = true;
+}
+
+void hideRed() {
+    red = 0;
+}
+
+void showTarget(uint32_t index) {
+    onsetValid = false; // Until the line interrupt sees it on the panel
+    const ScreenTarget &shown = screenTargets[index];
+    rendererOverlay(&targetBitmaps[index], shown.x, shown.y);
+}
+
+void showLeft() {
+    showTarget(0);
+}
+
+void showRight() {
+    showTarget(1);
+}
+
+void showCentre() {
+    showTarget(2);
+}
+
+void hideTarget() {
+    rendererOverlay(nullptr, 0, 0);
+}
+
+struct StimulusResponse {
+    char name;            // Tag in the per-stimulus means
+    void (*show)();       // Presents the stimulus
+    void (*hide)();       // Takes it away again
+    Response response;    // The correct response
+};
+
+constexpr StimulusResponse stimulusTable[] = {
+    { 'G', &showGreen, &hideGreen, Response::UserButton },
+    { 'R', &showRed, &hideRed, Response::ExternalButton },
+    { '<', &showLeft, &hideTarget, Response::TouchLeft },
+    { '>', &showRight, &hideTarget, Response::TouchRight },
+    { 'T', &showCentre, &hideTarget, Response::UserButton }, // Simple reaction only
+};
+static_assert(choiceStimuli >= 1 && choiceStimuli <= 4, "choiceStimuli must select 1 to 4 rows of stimulusTable");
 
 /**
- * @brief Starts the reaction phase.
- * Turns on the green LED and starts the timer.
+ * @brief True if one of the rows drawn in choice reaction expects
+ * response r.
  */
-void reaction1() {
-    elapsed = 0;
-    green = 1;    // LED on
-    t.start();    // Start measuring reaction time
-    reaction = true;
+constexpr bool choiceExpects(Response r, uint32_t row = 0) {
+    return choiceMode && row < choiceStimuli && (stimulusTable[row].response == r || choiceExpects(r, row + 1));
+}
+
+// Inputs the choice rows need on top of responseInput
+constexpr bool choiceNeedsTouch = choiceExpects(Response::TouchLeft) || choiceExpects(Response::TouchRight);
+constexpr bool choiceNeedsButton = choiceExpects(Response::UserButton);
+
+// Row shown in simple reaction
+constexpr uint8_t simpleStimulus = screenStimulus ? 4 : 0;
+
+// Stimuli drawn on the LCD: the FSM cannot start before the display
+constexpr bool stimulusOnScreen = screenStimulus || choiceStimuli > 2;
+
+// -------------------- FSM Actions --------------------
+// Each action runs once when its transition fires and performs the work of
+// entering the next state. They are called from interrupt context.
+
+/**
+ * @brief Does nothing; used for events that have no effect in a state.
+ */
+void ignore() {}
+
+/**
+ * @brief (Re)starts the countdown to Dormant. Called on entering Idle or
+ * Complete; the Complete countdown carries on into the Leaderboard, and a
+ * stale expiry in any other state is ignored by fsmTable.
+ */
+void armDormant() {
+    inactivity.attach(&inactive, dormantAfter);
 }
 
 /**
- * @brief Handles FSM logic and blinking based on current state.
+ * @brief TrialResult → Foreperiod: LED off and schedule the stimulus after
+ * a random delay.
  */
-void tick() {
-    if (state == 0) {  
-        // ---------------- Idle State ----------------
-        // Blink green LED at ~10Hz to indicate readiness
-        green = !green;
-        timeout.attach(&tick, 100ms);
+void startTrial() {
+    ledBlinkStop(); // Idle blink, if starting a session
+    red = 0;   // Clear the result indicator
+    green = 0; // LED off during random delay
+    t.reset();
+    foreperiod = foreperiodNext(config.foreperiod);
+    stimulus = choiceMode ? foreperiodRandom(choiceStimuli) : simpleStimulus;
+    onsetValid = false;
+    timeout.attach(&reaction1, std::chrono::microseconds(foreperiod));
+}
 
-    } else if (state == 1) {  
-        // ---------------- Reaction Phase ----------------
-        // Timer is running, waiting for user input
-        reaction = false;
-        t.reset();
+/**
+ * @brief Idle → Foreperiod: starts a new session with its first trial.
+ */
+void startSession() {
+    trial = 0;
+    sessionLength = calibrationActive() ? calibrationTrials : config.sessionTrials;
+    deferredQueue.call(&resetSession);
+    startTrial();
+}
 
-    } else if (state == 2) {  
-        // ---------------- Test Complete ----------------
-        // Blink red LED until reset
-        blinkRed();
+/**
+ * @brief Rapid-fire: schedules the next trial after a random inter-trial
+ * interval. Replaces any interval still pending.
+ */
+void armInterval() {
+    timeout.attach(&interval, std::chrono::microseconds(foreperiodNext(interTrialConfig)));
+}
+
+/**
+ * @brief Appends the current trial to the trial log and wakes the deferred
+ * thread. Ends the session once sessionLength trials have been logged;
+ * in rapid-fire, otherwise schedules the next trial.
+ */
+void logTrial(uint32_t reaction_us, uint8_t flags) {
+    if (calibrationActive()) {
+        flags |= TRIAL_CALIBRATION;
+    }
+    if (responseSource == CaptureInput::Touch) {
+        flags |= TRIAL_TOUCH;
+    }
+    uint8_t choice = choiceMode ? (uint8_t)(stimulus | (uint8_t)response << 4) : 0;
+    TrialRecord record = { foreperiod, reaction_us, (uint16_t)trial, flags, choice };
+    if (!trialLog.push({ record, onsetValid ? onset : captureTimerNow() })) {
+        trialLogDropped++;
+    }
+    deferredQueue.call(&drainTrials); // Format and display later
+
+    if (!choiceMode && !rapidFire) {
+        red = 1; // Result ready, press for the next trial (red is a stimulus in choice mode)
+    }
+    if (++trial >= sessionLength) {
+        dispatch<Event::SessionEnd>();
+    } else if (calibrationActive()) {
+        calibrationOnResult(); // Synthetic press for the next trial
+    } else if (rapidFire) {
+        armInterval();
+    }
+}
+
+/**
+ * @brief Foreperiod → TrialResult: pressed before the stimulus. The trial
+ * is logged with TRIAL_EARLY and excluded from the statistics.
+ */
+void earlyPress() {
+    timeout.detach(); // Cancel the pending stimulus
+    logTrial(0, TRIAL_EARLY);
+}
+
+/**
+ * @brief Foreperiod → Reaction: presents this trial's stimulus and starts
+ * timing.
+ */
+void showStimulus() {
+#if HW_CAPTURE
+    captureTimerArm();          // Drop any edge from before the stimulus
+    stimulusTable[stimulus].show();
+#else
+    stimulusTable[stimulus].show();
+    t.start();    // Start measuring reaction time (LED stimuli only)
+#endif
+    if (calibrationActive()) {
+        calibrationOnStimulus(onset);
     }
 }
 
 /**
- * @brief Toggles red LED to indicate test completion.
+ * @brief Reaction → TrialResult: captures the reaction time and logs it.
+ */
+void capturePress() {
+    const StimulusResponse &shown = stimulusTable[stimulus];
+    shown.hide();
+    if (!onsetValid) {
+        logTrial(0, TRIAL_EARLY); // Answered before the target reached the panel
+        return;
+    }
+
+#if HW_CAPTURE
+    // Only the response input is wired to the capture channel; other inputs
+    // were stamped on ISR entry
+    Response captured = (responseSource == CaptureInput::Touch) ? Response::Touch : Response::UserButton;
+    uint32_t pressed = (response == captured) ? captureTimerPress() : pressTime;
+    uint32_t elapsed = pressed - onset; // Latched at the edge, wrap-safe
+    bool calibrated = (response == Response::UserButton && captured == Response::UserButton);
+#else
+    t.stop();
+    uint32_t elapsed = t.elapsed_time().count();
+    bool calibrated = (response == Response::UserButton);
+#endif
+    if (calibrated && !calibrationActive()) {
+        // Remove the latency measured on BUTTON1's path, never below zero;
+        // other inputs go through different filters and ISRs
+        uint32_t offset = calibrationOffset_us;
+        elapsed = (elapsed > offset) ? elapsed - offset : 0;
+    }
+
+    // One table lookup; a tap's screen half is only known on deferredThread
+    uint8_t flags = 0;
+    if (response != Response::Touch && response != shown.response) {
+        flags |= TRIAL_WRONG;
+    }
+    logTrial(elapsed, flags);
+}
+
+/**
+ * @brief TrialResult → Complete: session done, start the red blink.
+ */
+void endSession() {
+    deferredQueue.call(&finishSession);
+    blinkRed();
+    armDormant();
+}
+
+/**
+ * @brief TrialResult → Idle in rapid-fire: session done, ready for the
+ * next one straight away.
+ */
+void endRapidSession() {
+    deferredQueue.call(&finishSession);
+    blinkGreen();
+    armDormant();
+}
+
+/**
+ * @brief TrialResult → TrialResult in rapid-fire: a press between trials.
+ * It belongs to neither trial (a late bounce, or a second press at the
+ * last one), so it only restarts the interval: the next foreperiod never
+ * begins under a held or bouncing button, and the press is not logged as
+ * an early press of a trial that had not started.
+ */
+void holdInterval() {
+    armInterval();
+}
+
+/**
+ * @brief Leaderboard → Idle: stop the red blink and wait for the next test.
+ */
+void restart() {
+    deferredQueue.call(&hideLeaderboard);
+    blinkGreen(); // Replaces the red blink
+    armDormant();
+}
+
+/**
+ * @brief Complete → Leaderboard: shows the ranking under the results.
+ */
+void openLeaderboard() {
+    deferredQueue.call(&showLeaderboard);
+    armDormant();
+}
+
+/**
+ * @brief Idle → Idle on the external button: selects the next profile.
+ */
+void nextProfile() {
+    profile = (profile + 1) % profileCount;
+    deferredQueue.call(&showProfile);
+    armDormant();
+}
+
+/**
+ * @brief Any state → Idle on the external button: resets everything.
+ */
+void resetAll() {
+    stimulusTable[stimulus].hide(); // If reset mid-trial
+    deferredQueue.call(&resetResults); // Clear results and LCD later
+    deferredQueue.call(&hideLeaderboard);
+
+    red = 0; // Turn off red LED
+    blinkGreen();  // Restart idle blinking
+    armDormant();
+}
+
+/**
+ * @brief Idle/Complete/Leaderboard → Dormant: everything that draws current is turned
+ * off. The display thread suspends the LCD and SDRAM, after which nothing
+ * holds the deep-sleep lock and the idle thread enters STOP mode.
+ */
+void goDormant() {
+    deferredQueue.call(&hideLeaderboard);
+    deferredQueue.cancel(timebaseEvent); // TIM2 stops in STOP mode
+    exportOnCommand(nullptr);            // The RX interrupt holds the deep-sleep lock
+    ledBlinkStop();
+    green = 0;
+    red = 0;
+    displayFlags.set(DISPLAY_POWER);
+}
+
+/**
+ * @brief Dormant → Idle: the waking press only wakes; it does not start or
+ * reset anything.
+ */
+void wake() {
+    displayFlags.set(DISPLAY_POWER);
+    exportOnCommand(&command);
+    deferredQueue.call(&restartTimebase);
+    blinkGreen();
+    armDormant();
+}
+
+// -------------------- FSM Transition Table --------------------
+
+struct Transition {
+    State next;        // State after the event
+    void (*action)();  // Work done on the way there
+};
+
+/**
+ * @brief The external button's cell while a trial runs: a reset in simple
+ * reaction, a response key (same action as the onboard button) in choice
+ * reaction.
+ */
+constexpr Transition externalDuringTrial(void (*response)()) {
+    return choiceMode ? Transition{State::TrialResult, response} : Transition{State::Idle, &resetAll};
+}
+
+/**
+ * @brief The external button's cell between trials: a reset in simple
+ * reaction. In choice reaction it is a response key, so a late or doubled
+ * answer lands here and is ignored; resetting would also clear the
+ * profile's stored results. Idle, Complete and the Leaderboard still reset.
+ */
+constexpr Transition externalBetweenTrials() {
+    return choiceMode ? Transition{State::TrialResult, &ignore} : Transition{State::Idle, &resetAll};
+}
+
+/**
+ * @brief TrialResult cells that differ in rapid-fire: a press waits for
+ * the next trial instead of starting it, the interval starts it, and the
+ * session ends in Idle rather than Complete.
+ */
+constexpr Transition pressBetweenTrials() {
+    return rapidFire ? Transition{State::TrialResult, &holdInterval} : Transition{State::Foreperiod, &startTrial};
+}
+
+constexpr Transition intervalBetweenTrials() {
+    return rapidFire ? Transition{State::Foreperiod, &startTrial} : Transition{State::TrialResult, &ignore};
+}
+
+constexpr Transition sessionEndAfterTrial() {
+    return rapidFire ? Transition{State::Idle, &endRapidSession} : Transition{State::Complete, &endSession};
+}
+
+constexpr size_t stateCount = static_cast<size_t>(State::Count);
+constexpr size_t eventCount = static_cast<size_t>(Event::Count);
+
+/**
+ * Every (state, event) pair has an entry, so dispatch is a single indexed
+ * load and an indirect call regardless of state. Add a state by adding a
+ * row; add an event by adding a column.
+ */
+constexpr Transition fsmTable[stateCount][eventCount] = {
+    //                  UserPress                               ExternalPress                Stimulus                           SessionEnd                       Inactivity                     Interval
+    /* Idle        */ { {State::Foreperiod, &startSession},     {State::Idle, &nextProfile}, {State::Idle, &ignore},            {State::Idle, &ignore},          {State::Dormant, &goDormant},  {State::Idle, &ignore} },
+    /* Foreperiod  */ { {State::TrialResult, &earlyPress},      externalDuringTrial(&earlyPress),   {State::Reaction, &showStimulus},  {State::Foreperiod, &ignore},    {State::Foreperiod, &ignore},  {State::Foreperiod, &ignore} },
+    /* Reaction    */ { {State::TrialResult, &capturePress},    externalDuringTrial(&capturePress), {State::Reaction, &ignore},        {State::Reaction, &ignore},      {State::Reaction, &ignore},    {State::Reaction, &ignore} },
+    /* TrialResult */ { pressBetweenTrials(),                   externalBetweenTrials(),     {State::TrialResult, &ignore},     sessionEndAfterTrial(),          {State::TrialResult, &ignore}, intervalBetweenTrials() },
+    /* Complete    */ { {State::Leaderboard, &openLeaderboard}, {State::Idle, &resetAll},    {State::Complete, &ignore},        {State::Complete, &ignore},      {State::Dormant, &goDormant},  {State::Complete, &ignore} },
+    /* Leaderboard */ { {State::Idle, &restart},                {State::Idle, &resetAll},    {State::Leaderboard, &ignore},     {State::Leaderboard, &ignore},   {State::Dormant, &goDormant},  {State::Leaderboard, &ignore} },
+    /* Dormant     */ { {State::Idle, &wake},                   {State::Idle, &wake},        {State::Dormant, &ignore},         {State::Dormant, &ignore},       {State::Dormant, &ignore},     {State::Dormant, &ignore} },
+};
+
+/**
+ * @brief Fires the transition for event E from the current state.
+ * E is a template parameter, so each call site indexes a fixed column.
+ */
+template <Event E>
+void dispatch() {
+    // Only ISRs dispatch, all at the default NVIC priority, so they never
+    // interleave: relaxed is enough
+    const Transition &tr = fsmTable[static_cast<size_t>(state.load(std::memory_order_relaxed))][static_cast<size_t>(E)];
+    state.store(tr.next, std::memory_order_relaxed);
+    tr.action();
+}
+
+// -------------------- LED Blinking --------------------
+
+// Both patterns run on TIM8 + DMA; no interrupt fires while they blink.
+
+/**
+ * @brief Blinks the green LED (PG13) to indicate readiness.
+ */
+void blinkGreen() {
+    ledBlinkStart(13, std::chrono::milliseconds(config.idleBlink_ms));
+}
+
+/**
+ * @brief Blinks the red LED (PG14) to indicate test completion.
  */
 void blinkRed() {
-    red = !red;
-    timeout.attach(&blinkRed, 300ms); // Blink every 300ms
+    ledBlinkStart(14, std::chrono::milliseconds(config.doneBlink_ms));
 }
 
 // -------------------- Interrupt Service Routines --------------------
 
+/**
+ * @brief Foreperiod timeout handler: the stimulus is due.
+ */
+void reaction1() {
+    PROFILE_SCOPE(Probe::StimulusIsr);
+    dispatch<Event::Stimulus>();
+}
+
+/**
+ * @brief Inactivity timeout handler: no press for dormantAfter.
+ */
+void inactive() {
+    PROFILE_SCOPE(Probe::InactivityIsr);
+    dispatch<Event::Inactivity>();
+}
+
+/**
+ * @brief Inter-trial interval handler (rapid-fire): the next trial is due.
+ */
+void interval() {
+    PROFILE_SCOPE(Probe::StimulusIsr);
+    dispatch<Event::Interval>();
+}
+
 /**
  * @brief Onboard button handler.
- * Handles state transitions:
- * - Start test
- * - Capture reaction time
- * - Restart or reset test depending on conditions
+ * Starts a test, captures the reaction time, or restarts/resets depending
+ * on the current state (see fsmTable).
  */
 void user() {
-    if (state == 0) {
-        // Start reaction test
-        state = 1;
-        green = 0; // LED off during random delay
-        tick();
+    PROFILE_SCOPE(Probe::UserIsr);
+    pressTime = captureTimerNow();
+    response = Response::UserButton;
+    dispatch<Event::UserPress>();
+}
+
+/**
+ * @brief External pushbutton handler.
+ * Resets everything: LCD, fastest time, state machine. In choice mode it
+ * is a response key during a trial.
+ */
+void external() {
+    PROFILE_SCOPE(Probe::ExternalIsr);
+    pressTime = captureTimerNow();
+    response = Response::ExternalButton;
+    dispatch<Event::ExternalPress>();
+}
 
-    } else if (state == 1 && reaction == true && elapsed >= 0) {
-        // User pressed button during active reaction phase
-        t.stop();
-        elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(t.elapsed_time()).count();
+/**
+ * @brief Touchscreen handler: same role as the onboard button.
+ */
+void touched() {
+    PROFILE_SCOPE(Probe::TouchIsr);
+    pressTime = captureTimerNow();
+    response = Response::Touch;
+    dispatch<Event::UserPress>();
+}
 
-        // Display latest time
-        sprintf(bufferElapsed, "The time taken was %llu ms", elapsed);
+/**
+ * @brief LTDC line hook: scanout has reached the first row of the screen
+ * target just shown. That is the stimulus onset.
+ */
+void targetOnScreen() {
+    PROFILE_SCOPE(Probe::ScanIsr);
+    onset = captureTimerNow();
+    onsetValid = true;
+}
 
-        // Update personal best if faster
-        if (elapsed < pB) {
-            pB = elapsed;
+/**
+ * @brief Byte received on the ST-LINK VCP. Commands:
+ * "T<unix seconds>" and a line end sets the RTC; "C..." and a line end
+ * lists or sets run-time parameters; 'N' dumps the merged statistics on a
+ * collector; with PROFILING, 'p' dumps the cycle profile and 'P' clears it.
+ */
+void command(char c) {
+    static bool setting = false;  // Inside a 'T' command
+    static uint32_t seconds = 0;
+    static bool configuring = false; // Inside a 'C' command
+    static ConfigLine line;
+    static uint32_t length = 0;
+    if (configuring) {
+        if (c != '\r' && c != '\n') {
+            if (length + 1 < sizeof(line.text)) {
+                line.text[length++] = c;
+            }
+            return;
+        }
+        configuring = false;
+        line.text[length] = '\0';
+        deferredQueue.call(&configure, line); // Copied into the event
+        return;
+    }
+    if (setting) {
+        if (c >= '0' && c <= '9') {
+            seconds = seconds * 10 + (c - '0');
+            return;
+        }
+        setting = false;
+        if (c == '\r' || c == '\n') {
+            deferredQueue.call(&timebaseSetWall, seconds);
         }
-        sprintf(bufferpB, "Personal Best: %d ms", pB);
+        return;
+    }
+    if (c == 'T') {
+        setting = true;
+        seconds = 0;
+    } else if (c == 'C') {
+        configuring = true;
+        length = 0;
+    } else if (c == 'N' && linkConfig.role == LinkRole::Collector) {
+        deferredQueue.call(&dumpNetwork);
+    }
+#if PROFILING
+    else if (c == 'p') {
+        deferredQueue.call(&dumpProfile);
+    } else if (c == 'P') {
+        deferredQueue.call(&profilerReset);
+    }
+#endif
+}
 
-        green = 0;   // Turn off LED
-        state = 2;   // Move to test completed
-        tick();
+// -------------------- Deferred Handlers --------------------
+// These run on deferredThread, never in interrupt context.
 
-    } else if (state == 2) {
-        // Restart test after completion
-        state = 0;
-        red = 0; // Stop red blinking
-        tick();
+/**
+ * @brief Publishes the working copy of the result text and wakes the main
+ * thread to redraw the changed lines. Every handler that edits `results`
+ * ends here.
+ */
+void publish(uint32_t changed) {
+    published.write(results);
+    displayFlags.set(changed);
+}
 
+/**
+ * @brief Processes every record waiting in the trial log.
+ */
+void drainTrials() {
+    LoggedTrial entry;
+    while (trialLog.pop(entry)) {
+        recordResult(entry.record, entry.stamp);
+    }
+}
+
+/**
+ * @brief Formats a captured reaction time and updates the personal best.
+ * The LCD shows milliseconds with three decimals, derived from the µs value.
+ * Early presses are shown but kept out of the personal best and statistics.
+ * @param record Trial logged by the press ISR.
+ * @param stamp TIM2 count of its stimulus onset, for the wall-clock stamp.
+ */
+void recordResult(TrialRecord record, uint32_t stamp) {
+    PROFILE_SCOPE(Probe::RecordResult);
+    if (choiceMode && !(record.flags & TRIAL_EARLY) && (record.choice >> 4) == (uint8_t)Response::Touch) {
+        // The tap's position has been read by now: settle which half it hit
+        Response zone = (touchscreen.x() < 120) ? Response::TouchLeft : Response::TouchRight;
+        record.choice = (record.choice & 0x0F) | (uint8_t)zone << 4;
+        if (zone != stimulusTable[record.choice & 0x0F].response) {
+            record.flags |= TRIAL_WRONG;
+        }
+    }
+    if (!(record.flags & TRIAL_CALIBRATION)) {
+        record.reaction_us = timebaseCorrect(record.reaction_us); // TIM2 µs → LSE µs
+    }
+    if (!(record.flags & (TRIAL_EARLY | TRIAL_WRONG | TRIAL_CALIBRATION))) {
+        record.flags |= validateTrial(config.validation, sessionWindow, record.reaction_us);
+    }
+    uint64_t wall = timebaseWall(stamp);
+    exportTrial(record, wall); // Every trial goes out, flagged or not
+
+    if (record.flags & TRIAL_CALIBRATION) {
+        calibrationRecord(record.reaction_us);
+        FormatBuffer(results.elapsed).text("Calibrating ").uint(record.index + 1).chr('/').uint(calibrationTrials);
+        publish(DISPLAY_ELAPSED);
+        return;
+    }
+
+    storeRecordTrial(profile, record);
+    linkTrial(profile, record);
+
+    if (record.flags & TRIAL_EARLY) {
+        FormatBuffer(results.elapsed).text("Too early! Wait for the LED");
+        results.fast++;
+        publish(DISPLAY_ELAPSED | DISPLAY_HISTOGRAM);
+        persist();
+        return;
+    }
+
+    if (choiceMode) {
+        recordChoice(record);
+        if (record.flags & TRIAL_WRONG) {
+            FormatBuffer(results.elapsed).text("Wrong response!");
+            publish(DISPLAY_ELAPSED | DISPLAY_CHOICE);
+            persist();
+            return;
+        }
+    }
+
+    uint32_t us = record.reaction_us;
+
+    if (record.flags & TRIAL_EXCLUDED) {
+        // Implausible time: shown for feedback, but counts for nothing
+        const char *reason = (record.flags & TRIAL_ANTICIPATION) ? "Anticipation "
+                             : (record.flags & TRIAL_LAPSE)      ? "Lapse "
+                                                                 : "Outlier ";
+        FormatBuffer(results.elapsed).text(reason).ms<3>(us).text(" ms, ignored");
+        uint32_t changed = choiceMode ? DISPLAY_ELAPSED | DISPLAY_CHOICE : DISPLAY_ELAPSED;
+        if (record.flags & TRIAL_ANTICIPATION) {
+            results.fast++;
+            changed |= DISPLAY_HISTOGRAM;
+        }
+        if (record.flags & (TRIAL_LAPSE | TRIAL_OUTLIER)) {
+            recordTrend(record, wall); // A slow outlier is still a lapse
+            changed |= DISPLAY_TREND;
+        }
+        publish(changed);
+        persist();
+        return;
+    }
+
+    // Display latest time
+    FormatBuffer(results.elapsed).text("The time taken was ").ms<3, 4>(us).text(" ms");
+
+    uint32_t changed = DISPLAY_ELAPSED;
+
+    // Fold into the profile's lifetime results
+    ProfileSummary summary = storeProfile(profile);
+    summary.add(us);
+
+    // Update personal best if faster
+    if (us < pB) {
+        pB = us;
+        summary.best_us = us;
+        leaderboard.update(profile, us);
+        FormatBuffer(results.pB).text("Personal Best: ").ms<3, 4>(pB).text(" ms");
+        changed |= DISPLAY_PB;
+    }
+    storeRecordProfile(profile, summary);
+    formatProfile();
+    changed |= DISPLAY_PROFILE;
+
+    // Fold into the running session statistics
+    sessionStats.add(us);
+    uint32_t mean = (uint32_t)(sessionStats.mean + 0.5f);
+    uint32_t sd = (uint32_t)(sqrtf(sessionStats.variance()) + 0.5f);
+    FormatBuffer(results.stats).text("Trial ").uint<3>(record.index + 1).chr('/').uint(config.sessionTrials)
+        .text(" Mean ").ms<3, 4>(mean).text(" ms");
+    FormatBuffer(results.spread).text("SD ").ms<1, 3>(sd).text(" Min ").ms<1, 4>(sessionStats.min)
+        .text(" Max ").ms<1, 4>(sessionStats.max);
+    memcpy(results.bins, sessionStats.bins, sizeof(results.bins));
+    recordTrend(record, wall);
+    changed |= DISPLAY_STATS | DISPLAY_HISTOGRAM | DISPLAY_TREND;
+
+    if (choiceMode) {
+        changed |= DISPLAY_CHOICE;
+    }
+
+    publish(changed); // Wake the main thread to redraw
+    persist();
+}
+
+/**
+ * @brief Choice reaction: counts the response and folds a correct, valid one into
+ * its stimulus' statistics, then formats the accuracy line.
+ */
+void recordChoice(const TrialRecord &record) {
+    choiceAnswered++;
+    if (!(record.flags & TRIAL_WRONG)) {
+        choiceCorrect++;
+    }
+    if (!(record.flags & TRIAL_EXCLUDED)) {
+        stimulusStats[record.choice & 0x0F].add(record.reaction_us);
+    }
+
+    FormatBuffer line(results.choice);
+    line.text("OK ").uint(choiceCorrect).chr('/').uint(choiceAnswered);
+    for (uint32_t i = 0; i < choiceStimuli; i++) {
+        line.chr(' ').chr(stimulusTable[i].name);
+        if (stimulusStats[i].count > 0) {
+            line.ms<0>((uint32_t)(stimulusStats[i].mean + 0.5f));
+        } else {
+            line.chr('-');
+        }
+    }
+}
+
+/**
+ * @brief Appends a drift in µs per ms as signed ms per minute.
+ */
+void formatDrift(FormatBuffer &line, float us_per_ms) {
+    float perMinute = us_per_ms * 60000.0f;
+    float magnitude = fminf(fabsf(perMinute), 9999999.0f); // A fit over a few seconds can be wild
+    line.chr(perMinute < 0.0f ? '-' : '+').ms<1>((uint32_t)(magnitude + 0.5f)).text(" ms/min");
+}
+
+/**
+ * @brief Adds a trial to the fatigue window and formats the rolling line:
+ * window size, mean, lapses and drift. Valid trials join the mean and the
+ * drift; lapses and outliers only take their place in the window, and
+ * count as lapses when slower than trendLapse_us.
+ * @param wall Wall time of its stimulus onset.
+ */
+void recordTrend(const TrialRecord &record, uint64_t wall) {
+    if (trendOrigin == 0) {
+        trendOrigin = wall;
+    }
+    bool timed = !(record.flags & TRIAL_EXCLUDED);
+    bool lapse = (record.flags & TRIAL_LAPSE) || record.reaction_us > trendLapse_us;
+    trend.add((uint32_t)((wall - trendOrigin) / 1000), record.reaction_us, timed, lapse);
+
+    FormatBuffer line(results.trend);
+    line.text("Last ").uint(trend.size()).chr(' ');
+    if (trend.mean() > 0) {
+        line.ms<1>(trend.mean());
     } else {
-        // Any invalid press → reset to idle
-        state = 0;
-        tick();
+        line.chr('-');
     }
+    line.text(" L").uint(trend.lapses()).chr(' ');
+    formatDrift(line, trend.slope());
 }
 
 /**
- * @brief External pushbutton handler.
- * Resets everything: LCD, fastest time, state machine.
+ * @brief Clears the personal best and the LCD text buffers.
  */
-void external() {
-    state = 0;
-    pB = INT_MAX;
-    elapsed = 0;
-    reaction = false;
+void resetResults() {
+    pB = UINT32_MAX;
+    storeRecordProfile(profile, { UINT32_MAX, 0, 0, 0 }); // The stored results go too
+    persist();
+    rebuildLeaderboard(); // A lower-ranked profile may move up
+    formatProfile();
 
     // Clear LCD text buffers
-    memset(bufferElapsed, 0, sizeof(bufferElapsed));
-    memset(bufferpB, 0, sizeof(bufferpB));
+    memset(results.elapsed, 0, sizeof(results.elapsed));
+    memset(results.pB, 0, sizeof(results.pB));
+    resetSession();
 
-    LCD.Clear(LCD_COLOR_WHITE); // Clear LCD screen
-    red = 0; // Turn off red LED
-    tick();  // Restart idle blinking
+    publish(DISPLAY_CLEAR | DISPLAY_PROFILE); // Main thread clears the screen
+}
+
+/**
+ * @brief Formats the profile line from the selected profile's summary:
+ * "Profile 1 n 18023 315.6 ms", the trial count and lifetime mean. At most
+ * 8 count and 4 mean digits, 29 characters, so it always fits the line.
+ */
+void formatProfile() {
+    const ProfileSummary &summary = storeProfile(profile);
+    FormatBuffer line(results.profile);
+    line.text("Profile ").uint(profile + 1).text(" n ").uint(summary.count);
+    if (summary.count > 0) {
+        line.chr(' ').ms<1>(summary.mean_us()).text(" ms");
+    }
+}
+
+/**
+ * @brief Loads the personal best of the newly selected profile and shows
+ * its line. The last trial shown belonged to someone else, so it goes.
+ */
+void showProfile() {
+    pB = storeProfile(profile).best_us;
+    if (pB != UINT32_MAX) {
+        FormatBuffer(results.pB).text("Personal Best: ").ms<3, 4>(pB).text(" ms");
+    } else {
+        memset(results.pB, 0, sizeof(results.pB));
+    }
+    memset(results.elapsed, 0, sizeof(results.elapsed));
+    formatProfile();
+    publish(DISPLAY_PB | DISPLAY_ELAPSED | DISPLAY_PROFILE);
+}
+
+/**
+ * @brief Ranks every profile's stored best from scratch. Only needed when
+ * a best is removed; improvements go through leaderboard.update().
+ */
+void rebuildLeaderboard() {
+    leaderboard.clear();
+    for (uint8_t p = 0; p < profileCount; p++) {
+        uint32_t best = storeProfile(p).best_us;
+        if (best != UINT32_MAX) {
+            leaderboard.update(p, best);
+        }
+    }
+}
+
+/**
+ * @brief Formats the leaderboard rows. The ranking is already sorted.
+ */
+void showLeaderboard() {
+    FormatBuffer(results.board[0]).text("Leaderboard");
+    for (uint32_t rank = 0; rank < leaderboardRows; rank++) {
+        char *row = results.board[rank + 1];
+        if (rank < leaderboard.size()) {
+            const auto &entry = leaderboard[rank];
+            FormatBuffer(row, sizeof(results.board[0])).uint(rank + 1).text(". Profile ")
+                .uint(entry.profile + 1).chr(' ').ms<3, 4>(entry.best_us).text(" ms");
+        } else {
+            row[0] = '\0';
+        }
+    }
+    publish(DISPLAY_BOARD);
+}
+
+/**
+ * @brief Blanks the leaderboard rows.
+ */
+void hideLeaderboard() {
+    memset(results.board, 0, sizeof(results.board));
+    publish(DISPLAY_BOARD);
+}
+
+/**
+ * @brief Takes the first TIM2/RTC pair, then keeps the drift estimate
+ * fresh every timebaseInterval (stopped while Dormant, restarted by wake()).
+ */
+void startTimebase() {
+    timebaseInit(deferredQueue);
+    timebaseEvent = deferredQueue.call_every(timebaseInterval, &timebaseSample);
+}
+
+/**
+ * @brief After Dormant: TIM2 stood still in STOP mode, so the old pairs no
+ * longer line up with it. Re-anchors wall time at once and samples again.
+ */
+void restartTimebase() {
+    timebaseRestart();
+    timebaseEvent = deferredQueue.call_every(timebaseInterval, &timebaseSample);
+}
+
+/**
+ * @brief Runs a 'C' command from the VCP and saves any change.
+ */
+void configure(ConfigLine line) {
+    if (configCommand(line.text)) {
+        persist();
+    }
+}
+
+/**
+ * @brief Collector: folds one trial from the bus (or its own, unit 0)
+ * into the statistics of that unit's profile. A profile index is only
+ * meaningful on the unit that recorded it (each unit has its own
+ * profiles), so trials from different units are never pooled.
+ */
+void mergeTrial(uint8_t unit, const LinkTrial &trial) {
+    if (unit > linkMaxUnits || trial.profile >= profileCount ||
+        (trial.flags & (TRIAL_EXCLUDED | TRIAL_CALIBRATION))) {
+        return;
+    }
+    networkStats[unit][trial.profile].add(trial.reaction_us);
+}
+
+/**
+ * @brief Sends one CSV line per unit and profile that has trials, with
+ * the statistics merged from the bus.
+ */
+void dumpNetwork() {
+    static const char header[] = "unit,profile,count,mean_us,sd_us,min_us,max_us\r\n";
+    exportText(header, sizeof(header) - 1);
+
+    char text[96];
+    for (uint32_t unit = 0; unit <= linkMaxUnits; unit++) {
+        for (uint32_t i = 0; i < profileCount; i++) {
+            const SessionStats &stats = networkStats[unit][i];
+            if (stats.count == 0) {
+                continue;
+            }
+            FormatBuffer line(text);
+            line.uint(unit).chr(',').uint(i + 1).chr(',').uint(stats.count).chr(',')
+                .uint((uint32_t)(stats.mean + 0.5f)).chr(',').uint((uint32_t)(sqrtf(stats.variance()) + 0.5f))
+                .chr(',').uint(stats.min).chr(',').uint(stats.max).text("\r\n");
+            exportText(text, line.length());
+        }
+    }
+}
+
+/**
+ * @brief Clears the session statistics at the start of a session.
+ */
+void resetSession() {
+    exportSessionStart();
+    sessionStats.reset();
+    sessionWindow.reset();
+    trend.reset();
+    trendOrigin = 0;
+    for (SessionStats &stats : stimulusStats) {
+        stats.reset();
+    }
+    choiceAnswered = 0;
+    choiceCorrect = 0;
+    memset(results.stats, 0, sizeof(results.stats));
+    memset(results.spread, 0, sizeof(results.spread));
+    memset(results.choice, 0, sizeof(results.choice));
+    memset(results.bins, 0, sizeof(results.bins));
+    results.fast = 0;
+    memset(results.trend, 0, sizeof(results.trend));
+    publish(DISPLAY_STATS | DISPLAY_CHOICE | DISPLAY_HISTOGRAM | DISPLAY_TREND);
+}
+
+/**
+ * @brief Sends the finished session's trials (batch export mode), and
+ * publishes the result if the session was a calibration run, or else the
+ * session's fatigue summary: lapses and drift over every trial.
+ */
+void finishSession() {
+    exportFlush();
+
+    if (calibrationActive()) {
+        CalibrationResult cal = calibrationFinish();
+        if (configStore("cal_offset_us", cal.offset_us)) {
+            persist(); // Applies from now on and after every reset
+        }
+        FormatBuffer(results.elapsed).text("Cal offset ").uint(cal.offset_us).text(" us");
+        FormatBuffer(results.stats).text("Jitter (SD) ").uint(cal.jitter_us).text(" us");
+        FormatBuffer(results.spread).text("Min ").uint(cal.min_us).text(" Max ").uint(cal.max_us).text(" us");
+        publish(DISPLAY_ELAPSED | DISPLAY_STATS);
+    } else {
+        FormatBuffer line(results.trend);
+        line.text("Session L").uint(trend.sessionLapses()).text(" drift ");
+        formatDrift(line, trend.sessionSlope());
+        publish(DISPLAY_TREND);
+    }
+}
+
+/**
+ * @brief Writes queued results to flash. While an erase is running, or
+ * an erase or compaction is due but the FSM is timing a reaction, it
+ * retries later instead of blocking this thread.
+ */
+void persist() {
+    static bool retryPosted = false;
+    if (retryPosted) {
+        return; // A retry is already on its way
+    }
+    bool mayErase = (state != State::Foreperiod && state != State::Reaction);
+    if (storeService(mayErase)) {
+        retryPosted = true;
+        deferredQueue.call_in(storeRetry, [] {
+            retryPosted = false;
+            persist();
+        });
+    }
+}
+
+/**
+ * @brief Sends one CSV line per probe: name, count, min and max cycles,
+ * then the log2 histogram (bin i counts runs of 2^i to 2^(i+1) - 1 cycles).
+ */
+void dumpProfile() {
+    static const char header[] = "probe,count,min_cycles,max_cycles,log2_bins\r\n";
+    exportText(header, sizeof(header) - 1);
+
+    char text[224];
+    for (uint32_t i = 0; i < probeCount; i++) {
+        const ProbeStats &stats = probeTable[i];
+        FormatBuffer line(text);
+        line.text(profilerName(static_cast<Probe>(i))).chr(',').uint(stats.count).chr(',')
+            .uint(stats.count > 0 ? stats.min : 0).chr(',').uint(stats.max);
+        for (uint16_t bin : stats.bins) {
+            line.chr(',').uint(bin);
+        }
+        line.text("\r\n");
+        exportText(text, line.length());
+    }
+}
+
+// -------------------- Display --------------------
+
+// Results panel rows. Labels are cached; only changed cells are redrawn.
+// The rows shown are those of defaultConfig; placePanel() moves them to
+// the loaded layout.
+TextLine elapsedLine(40, "The time taken was ");
+TextLine pbLine(80, "Personal Best: ");
+TextLine statsLine(100, "Trial ");
+TextLine spreadLine(116, "SD ");
+TextLine profileLine(20, "Profile ");
+TextLine choiceLine(132, "OK ");
+TextLine trendLine(60, "Last ");
+TextLine boardLines[leaderboardRows + 1] = { {150, "Leaderboard"}, {166}, {182}, {198}, {214}, {230} };
+HistogramView histogram(254);
+TextLine *const panelLines[] = { &elapsedLine, &pbLine, &statsLine, &spreadLine, &profileLine, &choiceLine, &trendLine,
+                                 &boardLines[0], &boardLines[1], &boardLines[2], &boardLines[3],
+                                 &boardLines[4], &boardLines[5] };
+
+/**
+ * @brief BSP font of the configured height, 8 or 12.
+ */
+sFONT *panelFont(uint8_t height) {
+    return (height == 8) ? &Font8 : &Font12;
+}
+
+/**
+ * @brief Moves the panel rows to config.layout. Before their init().
+ */
+void placePanel() {
+    const DisplayLayout &layout = config.layout;
+    profileLine.place(layout.profileY);
+    elapsedLine.place(layout.elapsedY);
+    pbLine.place(layout.pbY);
+    statsLine.place(layout.statsY);
+    spreadLine.place(layout.spreadY);
+    choiceLine.place(layout.choiceY);
+    trendLine.place(layout.trendY);
+    for (uint32_t i = 0; i <= leaderboardRows; i++) {
+        boardLines[i].place(layout.boardY + i * layout.boardStep);
+    }
+    histogram.place(layout.histogramY);
+}
+
+/**
+ * @brief Brings up the LCD and the renderer and draws the empty panel.
+ * Display thread. Results published before this are drawn by the first
+ * pass of the display loop; nothing is lost, the flags just wait.
+ */
+void startDisplay() {
+    // Double buffering and the configured font's glyph atlas
+    rendererInit(lcd(), panelFont(config.fontHeight));
+    for (uint32_t i = 0; i < screenTargetCount; i++) {
+        targetBitmaps[i] = rendererRenderFill(screenTargets[i].w, screenTargets[i].h, screenTargets[i].color);
+    }
+    rendererOnOverlayScan(&targetOnScreen);
+    placePanel();
+    for (TextLine *line : panelLines) {
+        line->init(LCD_COLOR_DARKBLUE, LCD_COLOR_WHITE);
+    }
+    histogram.init(LCD_COLOR_DARKBLUE, LCD_COLOR_RED, LCD_COLOR_ORANGE, LCD_COLOR_WHITE);
+}
+
+/**
+ * @brief Draws the lines whose flag is set in changed into the back
+ * buffer, from the latest published results.
+ */
+void redraw(uint32_t changed) {
+    PROFILE_SCOPE(Probe::Draw);
+    static DisplaySnapshot view; // Latest published result text
+    published.read(view); // Consistent copy, even mid-update
+
+    if (changed & DISPLAY_CLEAR) {
+        rendererClear(LCD_COLOR_WHITE); // Clear LCD screen
+        for (TextLine *line : panelLines) {
+            line->invalidate();
+        }
+        histogram.invalidate();
+    }
+    if (changed & DISPLAY_ELAPSED) {
+        elapsedLine.draw(view.elapsed);
+    }
+    if (changed & DISPLAY_PB) {
+        pbLine.draw(view.pB);
+    }
+    if (changed & DISPLAY_STATS) {
+        statsLine.draw(view.stats);
+        spreadLine.draw(view.spread);
+    }
+    if (changed & DISPLAY_PROFILE) {
+        profileLine.draw(view.profile);
+    }
+    if (changed & DISPLAY_CHOICE) {
+        choiceLine.draw(view.choice);
+    }
+    if (changed & DISPLAY_BOARD) {
+        for (uint32_t i = 0; i <= leaderboardRows; i++) {
+            boardLines[i].draw(view.board[i]);
+        }
+    }
+    if (changed & DISPLAY_TREND) {
+        trendLine.draw(view.trend);
+    }
+    if (changed & (DISPLAY_HISTOGRAM | DISPLAY_CLEAR)) {
+        histogram.draw(view.bins, view.fast);
+    }
 }
 
 // -------------------- Main Program --------------------
 int main() {
-    // Initialize hardware
+    // Staged boot: inputs, timers and the FSM first, so a test can start
+    // within milliseconds of power-up; the LCD comes up afterwards on this
+    // thread, which is the display thread and runs below deferredThread.
     green = 0;
     red = 0;
 
+    exportInit(exportConfig);
+    exportOnCommand(&command);
+#if PROFILING
+    profilerInit();
+#endif
+
+    // Profile results survive power cycles
+    storeInit();
+    configLoad(config); // Stored run-time parameters over the defaults
+    calibrationOffset_us = config.calibrationOffset_us; // From the last self-test
+    rebuildLeaderboard();
+    pB = storeProfile(profile).best_us;
+    if (pB != UINT32_MAX) {
+        FormatBuffer(results.pB).text("Personal Best: ").ms<3, 4>(pB).text(" ms");
+    }
+    formatProfile();
+    publish(DISPLAY_PB | DISPLAY_PROFILE); // Show the stored results once the LCD is up
+
+    // Start the deferred-work thread before any ISR can post to it
+    deferredThread.start(callback(&deferredQueue, &EventQueue::dispatch_forever));
+
     // Attach interrupts
-    userButton.fall(&user);
+    // Response input: the touchscreen when configured and present. Choice
+    // rows answered by the other input get it as well, stamped on ISR entry
+    touchscreen.fall(&touched);
+    bool touchPresent = (responseInput == CaptureInput::Touch || choiceNeedsTouch) && touchscreen.init(deferredQueue);
+    if (responseInput == CaptureInput::Touch && touchPresent) {
+        responseSource = CaptureInput::Touch;
+    }
+    if (responseSource == CaptureInput::Button || choiceNeedsButton) {
+        userButton.rise(&user); // BUTTON1 is active high
+    }
     external_button.fall(&external);
+    for (SessionStats (&unit)[profileCount] : networkStats) {
+        for (SessionStats &stats : unit) {
+            stats.reset();
+        }
+    }
+    linkOnTrial(&mergeTrial);
+    linkInit(linkConfig, deferredQueue);
+    foreperiodInit();
+    ledBlinkInit();
+    captureTimerInit(captureGlitchFilter, responseSource); // After the InterruptIn claimed the pin
+    deferredQueue.call(&startTimebase); // Needs TIM2 running
+    calibrationInit();
     __enable_irq();
 
-    // Configure LCD
-    LCD.SetFont(&Font12);
-    LCD.SetTextColor(LCD_COLOR_DARKBLUE);
+    if (stimulusOnScreen) {
+        startDisplay(); // Targets live on the overlay layer
+    }
+
+    // Start idle blinking: the tester takes a start press from here on
+    blinkGreen();
+    armDormant();
 
-    // Start idle blinking
-    tick();
+    // External button held at power-up → run the latency self-test
+    // (the loopback drives PA0 and times the green LED: simple reaction
+    // with button input only, press-paced trials)
+    if (!choiceMode && !screenStimulus && !rapidFire && responseSource == CaptureInput::Button && external_button.read() == 0) {
+        calibrationStart();
+    }
+
+    if (!stimulusOnScreen) {
+        startDisplay();
+    }
 
-    // Main loop updates LCD with results
+    // Main loop updates LCD with results. wait_any() blocks this thread until
+    // the FSM posts a change, so the idle thread can put the MCU to sleep
+    // instead of spinning on the LCD bus. Lines are drawn into the back
+    // buffer, then shown together at the next vertical blanking.
+    bool suspended = false;
     while (1) {
-        LCD.DisplayStringAt(0, 40, (uint8_t *)bufferElapsed, LEFT_MODE);
-        LCD.DisplayStringAt(0, 80, (uint8_t *)bufferpB, LEFT_MODE);
+        // While suspended only a power change is taken; redraws stay pending
+        uint32_t changed = displayFlags.wait_any(suspended ? DISPLAY_POWER : DISPLAY_ALL);
+
+        if (changed & DISPLAY_POWER) {
+            bool dormant = (state == State::Dormant);
+            if (dormant && !suspended) {
+                rendererSuspend();
+            } else if (!dormant && suspended) {
+                rendererResume();
+            }
+            suspended = dormant;
+            if (suspended) {
+                continue;
+            }
+        }
+        redraw(changed);
+        {
+            PROFILE_SCOPE(Probe::Present);
+            rendererPresent();
+        }
     }
 }
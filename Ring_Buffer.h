@@ -0,0 +1,79 @@
+/**
+ * =====================================================
+ * Ring Buffer – lock-free single-producer/single-consumer
+ * =====================================================
+ *
+ * Fixed-capacity FIFO with statically allocated storage. One context (for
+ * example an ISR) calls push(), one other context (a thread) calls pop().
+ * No heap, no mutexes and no critical sections: each index is written by
+ * exactly one side and published with release/acquire ordering, which on
+ * the Cortex-M4 is a plain load/store plus a DMB.
+ *
+ * Capacity must be a power of two so the free-running 32-bit indices can
+ * be masked instead of wrapped with a division.
+ *
+ * =====================================================
+ */
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <stdint.h>
+
+template <typename T, uint32_t Capacity>
+class RingBuffer {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "RingBuffer capacity must be a power of two");
+
+public:
+    /**
+     * @brief Appends an item. Producer side only.
+     * @return false if the buffer is full (the item is dropped).
+     */
+    bool push(const T &item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        items[h & (Capacity - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest item. Consumer side only.
+     * @return false if the buffer is empty.
+     */
+    bool pop(T &item) {
+        uint32_t tl = tail.load(std::memory_order_relaxed);
+        if (tl == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items[tl & (Capacity - 1)];
+        tail.store(tl + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Number of items waiting. Exact from either side's own view.
+     */
+    uint32_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    static constexpr uint32_t capacity() {
+        return Capacity;
+    }
+
+private:
+    T items[Capacity];
+    std::atomic<uint32_t> head{0}; // Next slot to write, owned by the producer
+    std::atomic<uint32_t> tail{0}; // Next slot to read, owned by the consumer
+};
+
+#endif // RING_BUFFER_H
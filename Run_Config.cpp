@@ -0,0 +1,316 @@
+#include "Run_Config.h"
+#include "Fixed_Format.h"
+#include "Flash_Store.h"
+#include "Histogram_View.h"
+#include "Trial_Export.h"
+
+enum class Kind : uint8_t {
+    U32,
+    U16,
+    U8,
+    Milli,   // float field, stored and entered in thousandths
+};
+
+struct Param {
+    const char *name;
+    Kind kind;
+    uint16_t offset;   // Of the field in RunConfig
+    uint32_t min;
+    uint32_t max;
+};
+
+#define PARAM(name, kind, field, min, max) { name, Kind::kind, offsetof(RunConfig, field), min, max }
+
+// Key = position: append only
+static const Param params[] = {
+    PARAM("trials", U32, sessionTrials, 1, configMaxTrials),
+    PARAM("fp_dist", U8, foreperiod.distribution, 0, 1),          // 0 uniform, 1 exponential
+    PARAM("fp_min_us", U32, foreperiod.min_us, 100000, 30000000),
+    PARAM("fp_max_us", U32, foreperiod.max_us, 100000, 30000000),
+    PARAM("fp_mean_us", U32, foreperiod.mean_us, 0, 30000000),
+    PARAM("floor_us", U32, validation.floor_us, 0, 1000000),
+    PARAM("ceiling_us", U32, validation.ceiling_us, 100000, 10000000),
+    PARAM("outlier_score", Milli, validation.outlierScore, 0, 20000),
+    PARAM("outlier_min", U32, validation.outlierMinTrials, 2, configMaxTrials),
+    PARAM("idle_blink_ms", U16, idleBlink_ms, 20, 5000),
+    PARAM("done_blink_ms", U16, doneBlink_ms, 20, 5000),
+    PARAM("font", U8, fontHeight, 8, 12),
+    PARAM("y_profile", U16, layout.profileY, 0, 319),
+    PARAM("y_elapsed", U16, layout.elapsedY, 0, 319),
+    PARAM("y_pb", U16, layout.pbY, 0, 319),
+    PARAM("y_stats", U16, layout.statsY, 0, 319),
+    PARAM("y_spread", U16, layout.spreadY, 0, 319),
+    PARAM("y_choice", U16, layout.choiceY, 0, 319),
+    PARAM("y_board", U16, layout.boardY, 0, 319),
+    PARAM("board_step", U16, layout.boardStep, 8, 64),
+    PARAM("y_histogram", U16, layout.histogramY, 0, configPanelHeight - HistogramView::height),
+    PARAM("y_trend", U16, layout.trendY, 0, 319),
+    PARAM("cal_offset_us", U32, calibrationOffset_us, 0, 100000), // Written by the self-test
+};
+
+constexpr uint32_t paramCount = sizeof(params) / sizeof(params[0]);
+static_assert(paramCount <= storeParams, "more parameters than flash slots");
+
+static RunConfig defaults;
+static const RunConfig *active = nullptr;
+
+static uint32_t get(const RunConfig &config, const Param &param) {
+    const uint8_t *field = reinterpret_cast<const uint8_t *>(&config) + param.offset;
+    switch (param.kind) {
+    case Kind::U32: {
+        uint32_t value;
+        memcpy(&value, field, sizeof(value));
+        return value;
+    }
+    case Kind::U16: {
+        uint16_t value;
+        memcpy(&value, field, sizeof(value));
+        return value;
+    }
+    case Kind::U8:
+        return *field;
+    case Kind::Milli: {
+        float value;
+        memcpy(&value, field, sizeof(value));
+        return (uint32_t)(value * 1000.0f + 0.5f);
+    }
+    }
+    return 0;
+}
+
+static void put(RunConfig &config, const Param &param, uint32_t value) {
+    uint8_t *field = reinterpret_cast<uint8_t *>(&config) + param.offset;
+    switch (param.kind) {
+    case Kind::U32:
+        memcpy(field, &value, sizeof(value));
+        break;
+    case Kind::U16: {
+        uint16_t narrow = (uint16_t)value;
+        memcpy(field, &narrow, sizeof(narrow));
+        break;
+    }
+    case Kind::U8:
+        *field = (uint8_t)value;
+        break;
+    case Kind::Milli: {
+        float scaled = value / 1000.0f;
+        memcpy(field, &scaled, sizeof(scaled));
+        break;
+    }
+    }
+}
+
+static bool foreperiodValid(const ForeperiodConfig &foreperiod) {
+    return foreperiod.min_us <= foreperiod.max_us;
+}
+
+static bool validationValid(const ValidationConfig &validation) {
+    return validation.floor_us < validation.ceiling_us;
+}
+
+static bool fontValid(uint8_t height) {
+    return height == 8 || height == 12;
+}
+
+/**
+ * @brief Every text row is one glyph tall and the histogram its own
+ * height: no two may overlap, and all must end on the panel.
+ */
+static bool layoutValid(const DisplayLayout &layout, uint8_t fontHeight) {
+    struct Band {
+        uint32_t y;
+        uint32_t height;
+    };
+    Band bands[9 + configBoardRows] = {
+        { layout.profileY, fontHeight }, { layout.elapsedY, fontHeight }, { layout.pbY, fontHeight },
+        { layout.statsY, fontHeight },   { layout.spreadY, fontHeight },  { layout.choiceY, fontHeight },
+        { layout.trendY, fontHeight },   { layout.histogramY, HistogramView::height },
+    };
+    for (uint32_t i = 0; i <= configBoardRows; i++) {
+        bands[8 + i] = { layout.boardY + i * (uint32_t)layout.boardStep, fontHeight }; // Title, then the rows
+    }
+
+    for (uint32_t i = 0; i < sizeof(bands) / sizeof(bands[0]); i++) {
+        if (bands[i].y + bands[i].height > configPanelHeight) {
+            return false;
+        }
+        for (uint32_t j = 0; j < i; j++) {
+            if (bands[i].y < bands[j].y + bands[j].height && bands[j].y < bands[i].y + bands[i].height) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief The defaults with every stored value (within its range) applied.
+ */
+static RunConfig storedConfig() {
+    RunConfig config = defaults;
+    for (uint32_t k = 0; k < paramCount; k++) {
+        uint32_t value;
+        if (storeParam(k, value) && value >= params[k].min && value <= params[k].max) {
+            put(config, params[k], value);
+        }
+    }
+    return config;
+}
+
+void configLoad(RunConfig &config) {
+    defaults = config;
+    active = &config;
+    config = storedConfig();
+    if (!foreperiodValid(config.foreperiod)) {
+        config.foreperiod = defaults.foreperiod;
+    }
+    if (!validationValid(config.validation)) {
+        config.validation = defaults.validation;
+    }
+    if (!fontValid(config.fontHeight) || !layoutValid(config.layout, config.fontHeight)) {
+        config.fontHeight = defaults.fontHeight;
+        config.layout = defaults.layout;
+    }
+}
+
+static void reply(const char *text) {
+    exportText(text, strlen(text));
+}
+
+static void formatValue(FormatBuffer &line, const Param &param, uint32_t value) {
+    if (param.kind == Kind::Milli) {
+        line.ms<3>(value);
+    } else {
+        line.uint(value);
+    }
+}
+
+/**
+ * @brief Parses a decimal value; Milli parameters take up to three
+ * decimals and come back in thousandths.
+ */
+static bool parseValue(const Param &param, const char *text, uint32_t &value) {
+    uint64_t whole = 0;
+    uint32_t digits = 0;
+    for (; *text >= '0' && *text <= '9'; text++) {
+        whole = whole * 10 + (*text - '0');
+        if (++digits > 10) {
+            return false;
+        }
+    }
+    if (param.kind == Kind::Milli) {
+        uint32_t scale = 1000;
+        whole *= scale;
+        if (*text == '.') {
+            for (text++; *text >= '0' && *text <= '9' && scale > 1; text++) {
+                scale /= 10;
+                whole += (uint64_t)(*text - '0') * scale;
+            }
+        }
+    }
+    if (digits == 0 || *text != '\0' || whole > UINT32_MAX) {
+        return false;
+    }
+    value = (uint32_t)whole;
+    return true;
+}
+
+/**
+ * @brief Key of the parameter whose name is the first length characters
+ * of name, or paramCount if there is none.
+ */
+static uint32_t findParam(const char *name, size_t length) {
+    uint32_t k = 0;
+    while (k < paramCount && (strlen(params[k].name) != length || memcmp(params[k].name, name, length) != 0)) {
+        k++;
+    }
+    return k;
+}
+
+/**
+ * @brief Checks value against the parameter's range and the rest of the
+ * stored set, and queues it for flash if both pass.
+ */
+static bool storeChecked(uint32_t k, uint32_t value) {
+    const Param &param = params[k];
+    if (value < param.min || value > param.max) {
+        return false;
+    }
+    RunConfig candidate = storedConfig();
+    put(candidate, param, value);
+    if (!foreperiodValid(candidate.foreperiod) || !validationValid(candidate.validation) ||
+        !fontValid(candidate.fontHeight) || !layoutValid(candidate.layout, candidate.fontHeight)) {
+        return false;
+    }
+    storeRecordParam(k, value);
+    return true;
+}
+
+static void list() {
+    reply("param,active,stored,default\r\n");
+    char text[64];
+    for (uint32_t k = 0; k < paramCount; k++) {
+        const Param &param = params[k];
+        FormatBuffer line(text);
+        line.text(param.name).chr(',');
+        formatValue(line, param, get(*active, param));
+        line.chr(',');
+        uint32_t value;
+        if (storeParam(k, value)) {
+            formatValue(line, param, value);
+        }
+        line.chr(',');
+        formatValue(line, param, get(defaults, param));
+        line.text("\r\n");
+        exportText(text, line.length());
+    }
+}
+
+bool configCommand(const char *line) {
+    if (active == nullptr) {
+        return false;
+    }
+    if (*line == '\0') {
+        list();
+        return false;
+    }
+
+    const char *equals = strchr(line, '=');
+    uint32_t k = (equals != nullptr) ? findParam(line, equals - line) : paramCount;
+    if (k == paramCount) {
+        reply("error: unknown parameter\r\n");
+        return false;
+    }
+    const Param &param = params[k];
+
+    if (equals[1] == '\0') {
+        storeClearParam(k);
+        reply("ok, default after reset\r\n");
+        return true;
+    }
+
+    uint32_t value;
+    if (!parseValue(param, equals + 1, value) || value < param.min || value > param.max) {
+        char text[64];
+        FormatBuffer error(text);
+        error.text("error: ").text(param.name).text(" takes ");
+        formatValue(error, param, param.min);
+        error.text("..");
+        formatValue(error, param, param.max);
+        error.text("\r\n");
+        exportText(text, error.length());
+        return false;
+    }
+
+    if (!storeChecked(k, value)) {
+        reply("error: inconsistent with the other parameters\r\n");
+        return false;
+    }
+    reply("ok, applies after reset\r\n");
+    return true;
+}
+
+bool configStore(const char *name, uint32_t value) {
+    uint32_t k = findParam(name, strlen(name));
+    return k < paramCount && storeChecked(k, value);
+}
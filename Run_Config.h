@@ -0,0 +1,94 @@
+/**
+ * =====================================================
+ * Run Config – run-time parameters, stored in flash
+ * =====================================================
+ *
+ * The parameters a study is likely to tune without a rebuild: trials per
+ * session, the foreperiod, the validation thresholds, the LED blink rates,
+ * the display font and layout, and the calibrated latency offset. The
+ * firmware's constexpr values are the defaults; anything set over the
+ * serial port (or, for the offset, measured by the self-test) is stored
+ * as a parameter entry in the Flash_Store log and overrides its default
+ * from the next boot.
+ *
+ * configLoad() runs once at boot and fills a plain RunConfig. Everything
+ * after that reads its fields directly: no lookup, no parsing and no
+ * flash access on the trial path. A stored set that is inconsistent as a
+ * whole (foreperiod min above max, say) falls back to the defaults for
+ * that group. For the font and layout that means rows at least one glyph
+ * apart, the histogram clear of them, and everything on the panel.
+ *
+ * Serial commands (thread side, from configCommand()):
+ *
+ *   C               list every parameter: name, active, stored, default
+ *   C<name>=<value> store a value (checked against its range)
+ *   C<name>=        back to the default
+ *
+ * Values are integers, except outlier_score (up to three decimals).
+ * Changes apply after a reset.
+ *
+ * Parameter keys are their position in the table in Run_Config.cpp;
+ * new parameters go at the end so stored values keep their meaning.
+ *
+ * =====================================================
+ */
+
+#ifndef RUN_CONFIG_H
+#define RUN_CONFIG_H
+
+#include "Foreperiod.h"
+#include "Trial_Validation.h"
+
+constexpr uint32_t configMaxTrials = 100;  // Upper bound for sessionTrials
+constexpr uint32_t configBoardRows = 5;    // Leaderboard rows below its title
+constexpr uint16_t configPanelHeight = 320;
+
+// Rows of the results panel (y of each line's top edge, in pixels)
+struct DisplayLayout {
+    uint16_t profileY;
+    uint16_t elapsedY;
+    uint16_t pbY;
+    uint16_t statsY;
+    uint16_t spreadY;
+    uint16_t choiceY;
+    uint16_t boardY;      // Leaderboard title
+    uint16_t boardStep;   // Between leaderboard rows
+    uint16_t histogramY;  // Histogram chart (HistogramView::height tall)
+    uint16_t trendY;      // Fatigue trend
+};
+
+struct RunConfig {
+    uint32_t sessionTrials;
+    ForeperiodConfig foreperiod;
+    ValidationConfig validation;
+    uint16_t idleBlink_ms;    // Green LED half-period while idle
+    uint16_t doneBlink_ms;    // Red LED half-period at test complete
+    uint8_t fontHeight;       // BSP font: 8 or 12 (a taller one clips the 30-character lines at 240 px)
+    DisplayLayout layout;
+    uint32_t calibrationOffset_us; // Last latency self-test result, subtracted from BUTTON1 times
+};
+
+/**
+ * @brief Overrides the defaults in config with the stored parameters.
+ * Call once at boot, after storeInit(); config's initial contents are
+ * kept as the defaults for configCommand().
+ */
+void configLoad(RunConfig &config);
+
+/**
+ * @brief Runs one 'C' command line (without the 'C' and the line end),
+ * replying over the VCP. Thread context.
+ * @return true if a change was queued for flash (storeService() due).
+ */
+bool configCommand(const char *line);
+
+/**
+ * @brief Stores a value for the named parameter, as "C<name>=<value>"
+ * would but without a reply. For results the firmware measures itself.
+ * Thread context.
+ * @return true if it was in range and queued for flash (storeService()
+ * due).
+ */
+bool configStore(const char *name, uint32_t value);
+
+#endif // RUN_CONFIG_H
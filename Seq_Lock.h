@@ -0,0 +1,62 @@
+/**
+ * =====================================================
+ * Seq Lock – tear-free snapshot, one writer, any readers
+ * =====================================================
+ *
+ * Publishes a value too large to store atomically. The writer bumps a
+ * sequence counter to odd, copies the value in and bumps it back to even;
+ * a reader copies the value out and retries if the counter was odd or
+ * changed meanwhile. Neither side takes a lock or masks interrupts, and
+ * the writer never waits.
+ *
+ * A reader can only be forced to retry by a write that preempts its copy,
+ * so it must not itself preempt the writer: the writer runs at a higher
+ * priority than every reader (or in the same thread). Never read from an
+ * ISR while a thread writes.
+ *
+ * T must be trivially copyable.
+ *
+ * =====================================================
+ */
+
+#ifndef SEQ_LOCK_H
+#define SEQ_LOCK_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+template <typename T>
+class SeqLock {
+public:
+    /**
+     * @brief Publishes a new value. Writer side only.
+     */
+    void write(const T &value) {
+        uint32_t s = sequence.load(std::memory_order_relaxed);
+        sequence.store(s + 1, std::memory_order_relaxed); // Odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&data, &value, sizeof(T));
+        sequence.store(s + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copies out the latest complete value. Reader side.
+     */
+    void read(T &value) const {
+        uint32_t before;
+        uint32_t after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            memcpy(&value, &data, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+    }
+
+private:
+    T data{};
+    std::atomic<uint32_t> sequence{0}; // Even when data is stable
+};
+
+#endif // SEQ_LOCK_H
@@ -0,0 +1,303 @@
+/**
+ * =====================================================
+ * Session Stats – streaming reaction-time statistics
+ * =====================================================
+ *
+ * Running count, mean and variance (Welford's algorithm), min, max and a
+ * fixed-bin histogram. Each trial is folded in with add() in O(1) time and
+ * constant memory; nothing is stored per trial.
+ *
+ * MedianWindow keeps the most recent N values sorted, for a robust centre
+ * (median) and spread (median absolute deviation) that a few wild trials
+ * cannot drag. add() costs O(N); median() is O(1) and mad() O(N), with N a
+ * small constant.
+ *
+ * TrendWindow follows the last N trials for fatigue: their mean, lapse
+ * count and least-squares slope of reaction time against time, plus the
+ * same slope over the whole session. The trials sit in a RingBuffer;
+ * add() pushes the new one, pops the one leaving the window and adjusts
+ * running sums, so an update is O(1) and nothing is rescanned. The sums
+ * are 64-bit integers, so no rounding error builds up over a long session.
+ *
+ * Reaction times are in microseconds.
+ *
+ * =====================================================
+ */
+
+#ifndef SESSION_STATS_H
+#define SESSION_STATS_H
+
+#include "Ring_Buffer.h"
+#include <stdint.h>
+
+struct SessionStats {
+    static constexpr uint32_t binCount = 16;         // Last bin collects everything slower
+    static constexpr uint32_t binWidth_us = 50000;   // 50 ms per bin → 0–800 ms
+
+    uint32_t count;
+    float mean;
+    float m2;              // Sum of squared deviations from the mean
+    uint32_t min;
+    uint32_t max;
+    uint16_t bins[binCount];
+
+    /**
+     * @brief Clears all statistics, ready for a new session.
+     */
+    void reset() {
+        count = 0;
+        mean = 0.0f;
+        m2 = 0.0f;
+        min = UINT32_MAX;
+        max = 0;
+        for (uint32_t i = 0; i < binCount; i++) {
+            bins[i] = 0;
+        }
+    }
+
+    /**
+     * @brief Folds one reaction time into the statistics.
+     */
+    void add(uint32_t us) {
+        count++;
+        float delta = (float)us - mean;
+        mean += delta / count;
+        m2 += delta * ((float)us - mean);
+
+        if (us < min) {
+            min = us;
+        }
+        if (us > max) {
+            max = us;
+        }
+
+        uint32_t bin = us / binWidth_us;
+        if (bin >= binCount) {
+            bin = binCount - 1;
+        }
+        if (bins[bin] < UINT16_MAX) {
+            bins[bin]++;
+        }
+    }
+
+    /**
+     * @brief Sample variance (µs²); 0 until there are two trials.
+     */
+    float variance() const {
+        return (count > 1) ? m2 / (count - 1) : 0.0f;
+    }
+};
+
+template <uint32_t N>
+class MedianWindow {
+public:
+    /**
+     * @brief Empties the window.
+     */
+    void reset() {
+        count = 0;
+        next = 0;
+    }
+
+    /**
+     * @brief Adds a value, dropping the oldest one once N are held.
+     */
+    void add(uint32_t us) {
+        uint32_t n = count;
+        if (n == N) {
+            // Take the oldest value out of the sorted copy
+            uint32_t i = 0;
+            while (sorted[i] != arrival[next]) {
+                i++;
+            }
+            for (n--; i < n; i++) {
+                sorted[i] = sorted[i + 1];
+            }
+        }
+        arrival[next] = us;
+        next = (next + 1 == N) ? 0 : next + 1;
+
+        // Insertion step: shift the larger values up one slot
+        uint32_t i = n;
+        while (i > 0 && sorted[i - 1] > us) {
+            sorted[i] = sorted[i - 1];
+            i--;
+        }
+        sorted[i] = us;
+        count = n + 1;
+    }
+
+    uint32_t size() const {
+        return count;
+    }
+
+    /**
+     * @brief Median of the window; 0 while it is empty.
+     */
+    uint32_t median() const {
+        if (count == 0) {
+            return 0;
+        }
+        uint32_t mid = count / 2;
+        return (count & 1) ? sorted[mid] : sorted[mid - 1] + (sorted[mid] - sorted[mid - 1]) / 2;
+    }
+
+    /**
+     * @brief Median absolute deviation from median(); 0 while empty.
+     * The deviations grow outward from the median on both sides of the
+     * sorted array, so merging the two sides yields them in order without
+     * sorting anything.
+     */
+    uint32_t mad() const {
+        if (count == 0) {
+            return 0;
+        }
+        uint32_t m = median();
+        uint32_t hi = 0;
+        while (hi < count && sorted[hi] < m) {
+            hi++;
+        }
+        int32_t lo = (int32_t)hi - 1;
+
+        uint32_t previous = 0;
+        uint32_t deviation = 0;
+        for (uint32_t k = 0; k <= count / 2; k++) {
+            previous = deviation;
+            if (hi < count && (lo < 0 || sorted[hi] - m <= m - sorted[lo])) {
+                deviation = sorted[hi++] - m;
+            } else {
+                deviation = m - sorted[lo--];
+            }
+        }
+        return (count & 1) ? deviation : previous + (deviation - previous) / 2;
+    }
+
+private:
+    uint32_t arrival[N];   // Ring in arrival order, for eviction
+    uint32_t sorted[N];    // The same values, ascending
+    uint32_t count = 0;
+    uint32_t next = 0;     // Ring slot of the next value
+};
+
+// Least-squares sums over (x, y) points that can be added and removed
+struct TrendSums {
+    uint32_t n;
+    int64_t x, y, xx, xy;
+
+    void reset() {
+        n = 0;
+        x = y = xx = xy = 0;
+    }
+
+    void add(int64_t px, int64_t py) {
+        n++;
+        x += px;
+        y += py;
+        xx += px * px;
+        xy += px * py;
+    }
+
+    void remove(int64_t px, int64_t py) {
+        n--;
+        x -= px;
+        y -= py;
+        xx -= px * px;
+        xy -= px * py;
+    }
+
+    /**
+     * @brief Slope of the fitted line, dy/dx; 0 until the points span
+     * more than one x.
+     */
+    float slope() const {
+        int64_t den = (int64_t)n * xx - x * x;
+        return (den > 0) ? (float)((int64_t)n * xy - x * y) / (float)den : 0.0f;
+    }
+};
+
+template <uint32_t N>
+class TrendWindow {
+public:
+    /**
+     * @brief Empties the window and the session sums.
+     */
+    void reset() {
+        Trial dropped;
+        while (trials.pop(dropped)) {
+        }
+        window.reset();
+        session.reset();
+        windowLapses = 0;
+        allLapses = 0;
+    }
+
+    /**
+     * @brief Adds a trial, dropping the oldest one once N are held.
+     * @param t_ms Time of the trial, in ms from any fixed origin.
+     * @param timed Joins the mean and the slopes (a valid time).
+     * @param lapse Counts as a lapse.
+     */
+    void add(uint32_t t_ms, uint32_t us, bool timed, bool lapse) {
+        Trial oldest;
+        if (trials.size() == N && trials.pop(oldest)) {
+            if (oldest.timed) {
+                window.remove(oldest.t_ms, oldest.us);
+            }
+            windowLapses -= oldest.lapse;
+        }
+        trials.push({ t_ms, us, timed, lapse });
+        if (timed) {
+            window.add(t_ms, us);
+            session.add(t_ms, us);
+        }
+        windowLapses += lapse;
+        allLapses += lapse;
+    }
+
+    uint32_t size() const {
+        return trials.size();
+    }
+
+    uint32_t lapses() const {
+        return windowLapses;
+    }
+
+    uint32_t sessionLapses() const {
+        return allLapses;
+    }
+
+    /**
+     * @brief Mean of the timed trials in the window; 0 if there are none.
+     */
+    uint32_t mean() const {
+        return (window.n > 0) ? (uint32_t)((window.y + window.n / 2) / window.n) : 0;
+    }
+
+    /**
+     * @brief Drift of the timed trials in the window, µs per ms: positive
+     * when responses are slowing down.
+     */
+    float slope() const {
+        return window.slope();
+    }
+
+    float sessionSlope() const {
+        return session.slope();
+    }
+
+private:
+    struct Trial {
+        uint32_t t_ms;
+        uint32_t us;
+        bool timed;
+        bool lapse;
+    };
+
+    RingBuffer<Trial, N> trials;
+    TrendSums window = {};   // Timed trials in the window
+    TrendSums session = {};  // Every timed trial since reset()
+    uint32_t windowLapses = 0;
+    uint32_t allLapses = 0;
+};
+
+#endif // SESSION_STATS_H
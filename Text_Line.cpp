@@ -0,0 +1,50 @@
+#include "Text_Line.h"
+
+constexpr uint16_t panelWidth = 240;
+
+TextLine::TextLine(uint16_t y, const char *label) : y(y), label(label) {
+    invalidate();
+}
+
+void TextLine::place(uint16_t y) {
+    this->y = y;
+}
+
+void TextLine::init(uint32_t fg, uint32_t bg) {
+    this->fg = fg;
+    this->bg = bg;
+    uint32_t fit = panelWidth / rendererGlyphWidth();
+    columns = (fit < maxColumns) ? fit : maxColumns;
+    labelLength = 0;
+    if (label != nullptr && strlen(label) <= columns) { // A wider label is drawn cell by cell, clipped
+        labelLength = strlen(label);
+        labelBitmap = rendererRenderText(label, fg, bg);
+    }
+}
+
+void TextLine::draw(const char *text) {
+    uint32_t length = strnlen(text, columns);
+    uint32_t column = 0;
+
+    if (labelLength > 0 && labelBitmap.address != 0 && length >= labelLength &&
+        memcmp(text, label, labelLength) == 0) {
+        if (memcmp(shown, label, labelLength) != 0) {
+            rendererBlit(labelBitmap, 0, y);
+            memcpy(shown, label, labelLength);
+        }
+        column = labelLength;
+    }
+
+    uint16_t cellWidth = rendererGlyphWidth();
+    for (; column < columns; column++) {
+        char c = (column < length) ? text[column] : ' ';
+        if (shown[column] != c) {
+            rendererGlyph(column * cellWidth, y, c, fg, bg);
+            shown[column] = c;
+        }
+    }
+}
+
+void TextLine::invalidate() {
+    memset(shown, ' ', sizeof(shown));
+}
@@ -0,0 +1,66 @@
+/**
+ * =====================================================
+ * Text Line – cached, cell-diffed text row
+ * =====================================================
+ *
+ * Keeps the characters currently on screen for one row of the results
+ * panel. draw() compares the new text with them and redraws only the glyph
+ * cells that differ, so a new reaction time typically touches three or
+ * four digit cells instead of the whole line.
+ *
+ * An optional static label (e.g. "Personal Best: ") is rendered once into
+ * a cached bitmap at init. Whenever the text starts with the label and the
+ * label is not already on screen (after a clear, or after another message
+ * used the row), it is restored with one DMA2D copy instead of glyph by
+ * glyph.
+ *
+ * Display thread only.
+ *
+ * =====================================================
+ */
+
+#ifndef TEXT_LINE_H
+#define TEXT_LINE_H
+
+#include "Lcd_Renderer.h"
+
+class TextLine {
+public:
+    static constexpr uint32_t maxColumns = 34; // 240 px / 7 px (Font12); fewer with wider fonts
+
+    TextLine(uint16_t y, const char *label = nullptr);
+
+    /**
+     * @brief Moves the row to y (run-time layout). Call before init().
+     */
+    void place(uint16_t y);
+
+    /**
+     * @brief Renders the label bitmap and fits the row to the font's cell
+     * width. Call after rendererInit().
+     */
+    void init(uint32_t fg, uint32_t bg);
+
+    /**
+     * @brief Redraws the cells of text that differ from the screen.
+     */
+    void draw(const char *text);
+
+    /**
+     * @brief Forgets the screen contents after the row was wiped to bg
+     * (e.g. by rendererClear()).
+     */
+    void invalidate();
+
+private:
+    uint16_t y;
+    const char *label;
+    uint32_t columns = maxColumns; // Cells that fit across the panel
+    uint32_t labelLength = 0;
+    RendererBitmap labelBitmap = {0, 0, 0};
+    uint32_t fg = 0;
+    uint32_t bg = 0;
+    char shown[maxColumns]; // Characters on screen; ' ' is a blank cell
+};
+
+#endif // TEXT_LINE_H
@@ -0,0 +1,179 @@
+#include "Time_Base.h"
+#include "Capture_Timer.h"
+
+constexpr uint32_t RTC_ALARM_EXTI = 1UL << 17; // EXTI line of the RTC alarms
+
+// One simultaneous reading of both clocks
+struct Pair {
+    uint32_t tim2;    // TIM2 count right after an RTC sub-second tick
+    uint64_t rtc_us;  // RTC time of that tick, µs since the Unix epoch
+};
+
+static Pair window[timebaseWindow];  // Ring, oldest at window[oldest]
+static uint32_t oldest = 0;
+static uint32_t count = 0;
+static Pair latest = {0, 0};          // Newest pair: the reference for timebaseWall()
+static bool lseClocked = false;
+static volatile int32_t driftQ32 = 0; // TIM2 rate error, in units of 2^-32
+static EventQueue *pairQueue = nullptr; // Runs addPair()
+
+static uint32_t bcd(uint32_t value) {
+    return (value >> 4) * 10 + (value & 0x0F);
+}
+
+/**
+ * @brief Days from 1970-01-01 to a Gregorian date.
+ */
+static int32_t daysFromCivil(int32_t y, int32_t m, int32_t d) {
+    y -= (m <= 2);
+    int32_t era = (y >= 0 ? y : y - 399) / 400;
+    int32_t yoe = y - era * 400;
+    int32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+/**
+ * @brief RTC time now, µs since the Unix epoch, to one sub-second tick
+ * (3.9 ms with Mbed's prescalers). Calendar registers are read in SSR,
+ * TR, DR order, which keeps them consistent through the shadow-register
+ * lock.
+ */
+static uint64_t readCalendar() {
+    uint32_t ssr = RTC->SSR;
+    uint32_t tr = RTC->TR;
+    uint32_t dr = RTC->DR;
+    uint32_t prediv = RTC->PRER & RTC_PRER_PREDIV_S;
+
+    // Mbed's STM32 RTC driver counts years from 1968 (leap year aligned)
+    int32_t year = 1968 + (int32_t)bcd((dr >> 16) & 0xFF);
+    int32_t month = (int32_t)bcd((dr >> 8) & 0x1F);
+    int32_t day = (int32_t)bcd(dr & 0x3F);
+    uint32_t seconds = bcd((tr >> 16) & 0x3F) * 3600 + bcd((tr >> 8) & 0x7F) * 60 + bcd(tr & 0x7F);
+    uint64_t epoch = (uint64_t)daysFromCivil(year, month, day) * 86400 + seconds;
+    uint32_t fraction = (ssr <= prediv) ? prediv - ssr : 0;
+    return epoch * 1000000 + (uint64_t)fraction * 1000000 / (prediv + 1);
+}
+
+/**
+ * @brief Opens RTC write access. Mbed's lp_ticker drives the wakeup timer
+ * through the same WPR and CR, from any interrupt that attaches a
+ * LowPowerTimeout, so unlock → CR change → rtcLock() runs as a critical
+ * section: a preempting unlock/relock or CR write cannot land in between.
+ */
+static void rtcUnlock() {
+    core_util_critical_section_enter();
+    RTC->WPR = 0xCA;
+    RTC->WPR = 0x53;
+}
+
+static void rtcLock() {
+    RTC->WPR = 0xFF;
+    core_util_critical_section_exit();
+}
+
+static void addPair(Pair pair);
+
+/**
+ * @brief RTC alarm A: the seconds just incremented, an exact LSE instant.
+ * Reads TIM2 first, then disarms the alarm and hands the pair on.
+ */
+static void alarmIrq() {
+    uint32_t now = captureTimerNow();
+    rtcUnlock();
+    RTC->CR &= ~(RTC_CR_ALRAE | RTC_CR_ALRAIE);
+    RTC->ISR = ~(RTC_ISR_ALRAF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT); // rc_w0 flag
+    rtcLock();
+    EXTI->PR = RTC_ALARM_EXTI;
+
+    // The shadow registers may still show the end of the last second,
+    // so round the reading to the second that just began
+    uint64_t calendar = readCalendar();
+    pairQueue->call(&addPair, Pair{ now, (calendar + 500000) / 1000000 * 1000000 });
+}
+
+bool timebaseInit(EventQueue &queue) {
+    pairQueue = &queue;
+    (void)time(nullptr); // Makes Mbed bring the RTC up if nothing has yet
+    lseClocked = (RCC->BDCR & RCC_BDCR_RTCSEL) == RCC_BDCR_RTCSEL_0 && (RCC->BDCR & RCC_BDCR_LSERDY);
+
+    // Alarm A, every field masked: fires each time the seconds increment
+    PWR->CR |= PWR_CR_DBP;
+    rtcUnlock();
+    RTC->CR &= ~(RTC_CR_ALRAE | RTC_CR_ALRAIE);
+    while (!(RTC->ISR & RTC_ISR_ALRAWF)) {
+    }
+    RTC->ALRMAR = RTC_ALRMAR_MSK4 | RTC_ALRMAR_MSK3 | RTC_ALRMAR_MSK2 | RTC_ALRMAR_MSK1;
+    RTC->ALRMASSR = 0; // MASKSS 0: no sub-second comparison
+    rtcLock();
+    EXTI->IMR |= RTC_ALARM_EXTI;
+    EXTI->RTSR |= RTC_ALARM_EXTI;
+    NVIC_SetVector(RTC_Alarm_IRQn, (uint32_t)&alarmIrq);
+    NVIC_SetPriority(RTC_Alarm_IRQn, 6); // Below the capture and button interrupts
+    NVIC_EnableIRQ(RTC_Alarm_IRQn);
+
+    timebaseRestart();
+    return lseClocked;
+}
+
+void timebaseSample() {
+    rtcUnlock();
+    RTC->ISR = ~(RTC_ISR_ALRAF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+    RTC->CR |= RTC_CR_ALRAE | RTC_CR_ALRAIE;
+    rtcLock();
+    EXTI->PR = RTC_ALARM_EXTI; // No stale edge from an earlier second
+}
+
+void timebaseRestart() {
+    count = 0;
+    latest = { captureTimerNow(), readCalendar() }; // Coarse until the alarm's pair
+    timebaseSample();
+}
+
+/**
+ * @brief Folds one pair into the window and the estimate. Thread context.
+ */
+static void addPair(Pair pair) {
+    if (count > 0) {
+        // Both clocks must have advanced together since the previous pair
+        int64_t tim2 = (uint32_t)(pair.tim2 - latest.tim2);
+        int64_t rtc = (int64_t)(pair.rtc_us - latest.rtc_us);
+        int64_t error = (tim2 > rtc) ? tim2 - rtc : rtc - tim2;
+        if (rtc <= 0 || error * 1000000 > (int64_t)timebaseMaxDrift_ppm * rtc) {
+            count = 0; // Discontinuity: start a new window, keep the estimate
+        }
+    }
+    if (count == timebaseWindow) {
+        oldest = (oldest + 1) % timebaseWindow;
+        count--;
+    }
+    window[(oldest + count) % timebaseWindow] = pair;
+    count++;
+    latest = pair;
+
+    const Pair &first = window[oldest];
+    int64_t span = (int64_t)(pair.rtc_us - first.rtc_us);
+    if (lseClocked && span >= timebaseMinSpan_us) {
+        int64_t tim2 = (uint32_t)(pair.tim2 - first.tim2);
+        driftQ32 = (int32_t)(((tim2 - span) * ((int64_t)1 << 32)) / tim2);
+    }
+}
+
+void timebaseSetWall(uint32_t seconds) {
+    set_time(seconds);
+    timebaseRestart();
+}
+
+int32_t timebaseDrift_ppb() {
+    return (int32_t)(((int64_t)driftQ32 * 1000000000) >> 32);
+}
+
+uint32_t timebaseCorrect(uint32_t us) {
+    return us - (int32_t)(((int64_t)us * driftQ32) >> 32);
+}
+
+uint64_t timebaseWall(uint32_t stamp) {
+    int32_t since = (int32_t)(stamp - latest.tim2); // Either side of the pair
+    int64_t corrected = since - (((int64_t)since * driftQ32) >> 32);
+    return latest.rtc_us + corrected;
+}
@@ -0,0 +1,90 @@
+/**
+ * =====================================================
+ * Time Base – TIM2 disciplined against the RTC
+ * =====================================================
+ *
+ * TIM2 counts microseconds of the PLL clock, so its rate is only as good
+ * as the HSE crystal (tens of ppm, and it stops in STOP mode). The RTC
+ * runs from the 32.768 kHz LSE, which keeps going through any sleep mode
+ * and can be set to a wall clock shared by every unit in a study.
+ *
+ * timebaseSample() pairs the two without waiting: it arms RTC alarm A for
+ * the next increment of the seconds, an exact LSE instant, and the alarm
+ * interrupt reads TIM2 on entry and posts the pair to the EventQueue given
+ * to timebaseInit(). From a window of such pairs it estimates TIM2's rate
+ * error against the LSE:
+ *
+ *   drift = (Δtim2 − Δrtc) / Δtim2,   over the oldest → newest pair
+ *
+ * A pair only counts once the window spans timebaseMinSpan, where the
+ * interrupt latency and its jitter are far below 1 ppm. A pair that disagrees
+ * with the last one by more than timebaseMaxDrift (TIM2 stopped in STOP
+ * mode, the RTC was set, TIM2 wrapped between pairs) restarts the window.
+ *
+ * timebaseCorrect() removes the drift from a measured interval and
+ * timebaseWall() turns a TIM2 timestamp into RTC wall time. Both are
+ * plain arithmetic, cheap enough for any context; the estimate itself is
+ * owned by the thread calling timebaseSample().
+ *
+ * Mbed owns the RTC (its wakeup timer runs the lp_ticker); only alarm A,
+ * which Mbed leaves unused, is configured here. Drift is only estimated if the RTC is clocked from the LSE
+ * ("target.lse_available": 1, X3 fitted); otherwise times stay
+ * uncorrected and wall time is only as good as the LSI.
+ *
+ * =====================================================
+ */
+
+#ifndef TIME_BASE_H
+#define TIME_BASE_H
+
+#include "mbed.h"
+
+constexpr uint32_t timebaseWindow = 16;              // Pairs kept for the estimate
+constexpr uint32_t timebaseMinSpan_us = 60000000;    // 60 s before the first estimate
+constexpr int32_t timebaseMaxDrift_ppm = 500;        // Beyond this a pair is a discontinuity
+
+/**
+ * @brief Checks the RTC clock source, sets up alarm A and asks for the
+ * first pair. Thread context.
+ * @param queue Folds the pairs into the estimate; that thread owns it.
+ * @return true if the RTC runs from the LSE, i.e. drift can be estimated.
+ */
+bool timebaseInit(EventQueue &queue);
+
+/**
+ * @brief Asks for one TIM2/RTC pair at the next RTC second, at most a
+ * second from now, and returns at once. Thread context.
+ */
+void timebaseSample();
+
+/**
+ * @brief Starts a new window after TIM2 stopped (STOP mode): wall time is
+ * re-anchored at once on a reading good to one RTC sub-second tick
+ * (3.9 ms), then on the exact pair asked for. Thread context.
+ */
+void timebaseRestart();
+
+/**
+ * @brief Sets the RTC (Unix seconds) and restarts the estimate. Thread
+ * context.
+ */
+void timebaseSetWall(uint32_t seconds);
+
+/**
+ * @brief Current TIM2 rate error against the LSE, parts per billion
+ * (positive: TIM2 runs fast). 0 until a window spans timebaseMinSpan_us.
+ */
+int32_t timebaseDrift_ppb();
+
+/**
+ * @brief A TIM2 interval (µs) in LSE microseconds.
+ */
+uint32_t timebaseCorrect(uint32_t us);
+
+/**
+ * @brief Wall time of a TIM2 timestamp, µs since the Unix epoch. Valid for
+ * stamps up to ~35 minutes either side of the last pair.
+ */
+uint64_t timebaseWall(uint32_t stamp);
+
+#endif // TIME_BASE_H
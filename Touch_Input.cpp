@@ -0,0 +1,130 @@
+#include "Touch_Input.h"
+
+constexpr int stmpeAddress = 0x82; // 8-bit I2C address (A0 low)
+constexpr uint16_t stmpeChipId = 0x0811;
+
+// STMPE811 registers
+constexpr uint8_t REG_CHIP_ID = 0x00;    // 16-bit
+constexpr uint8_t REG_SYS_CTRL1 = 0x03;
+constexpr uint8_t REG_SYS_CTRL2 = 0x04;
+constexpr uint8_t REG_INT_CTRL = 0x09;
+constexpr uint8_t REG_INT_EN = 0x0A;
+constexpr uint8_t REG_INT_STA = 0x0B;
+constexpr uint8_t REG_ADC_CTRL1 = 0x20;
+constexpr uint8_t REG_ADC_CTRL2 = 0x21;
+constexpr uint8_t REG_TSC_CTRL = 0x40;
+constexpr uint8_t REG_TSC_CFG = 0x41;
+constexpr uint8_t REG_FIFO_TH = 0x4A;
+constexpr uint8_t REG_FIFO_STA = 0x4B;
+constexpr uint8_t REG_FIFO_SIZE = 0x4C;
+constexpr uint8_t REG_TSC_DATA_X = 0x4D; // 16-bit, then Y at 0x4F
+constexpr uint8_t REG_TSC_I_DRIVE = 0x58;
+
+constexpr uint8_t SYS_CTRL1_SOFT_RESET = 0x02;
+constexpr uint8_t INT_CTRL_GLOBAL = 0x01;      // Level, active low
+constexpr uint8_t INT_TOUCH_DET = 0x01;
+constexpr uint8_t INT_FIFO_TH = 0x02;
+constexpr uint8_t TSC_CTRL_EN_XY = 0x03;       // Enabled, X/Y only (no Z)
+constexpr uint8_t TSC_CTRL_STA = 0x80;         // Finger down
+constexpr uint8_t FIFO_STA_RESET = 0x01;
+
+// Detection speed over coordinate accuracy: 2-sample average, 50 µs touch
+// detect delay, 500 µs settling. The first sample is ready well under 1 ms.
+constexpr uint8_t tscConfig = (1 << 6) | (1 << 3) | 2;
+
+constexpr uint32_t rawMax = 4096; // 12-bit readings
+constexpr uint16_t panelWidth = 240;
+constexpr uint16_t panelHeight = 320;
+
+TouchInput::TouchInput(PinName irq, PinName sda, PinName scl) : i2c(sda, scl), irq(irq, PullUp) {
+}
+
+bool TouchInput::writeReg(uint8_t reg, uint8_t value) {
+    const char data[2] = { (char)reg, (char)value };
+    return i2c.write(stmpeAddress, data, 2) == 0;
+}
+
+uint8_t TouchInput::readReg(uint8_t reg) {
+    char value = 0;
+    i2c.write(stmpeAddress, (const char *)&reg, 1, true);
+    i2c.read(stmpeAddress, &value, 1);
+    return (uint8_t)value;
+}
+
+bool TouchInput::init(EventQueue &queue) {
+    this->queue = &queue;
+    i2c.frequency(400000);
+
+    char id[2] = { 0, 0 };
+    const char reg = REG_CHIP_ID;
+    if (i2c.write(stmpeAddress, &reg, 1, true) != 0 || i2c.read(stmpeAddress, id, 2) != 0 ||
+        (((uint8_t)id[0] << 8) | (uint8_t)id[1]) != stmpeChipId) {
+        return false;
+    }
+
+    writeReg(REG_SYS_CTRL1, SYS_CTRL1_SOFT_RESET);
+    ThisThread::sleep_for(10ms);
+    writeReg(REG_SYS_CTRL1, 0);
+    writeReg(REG_SYS_CTRL2, 0);         // All blocks clocked
+    writeReg(REG_ADC_CTRL1, 0x49);      // 80-clock sample time, 12-bit
+    writeReg(REG_ADC_CTRL2, 0x01);      // ADC clock 3.25 MHz
+    writeReg(REG_TSC_CFG, tscConfig);
+    writeReg(REG_FIFO_TH, 1);           // Interrupt on the first sample
+    writeReg(REG_FIFO_STA, FIFO_STA_RESET);
+    writeReg(REG_FIFO_STA, 0);
+    writeReg(REG_TSC_I_DRIVE, 0x01);    // 50 mA
+    writeReg(REG_TSC_CTRL, TSC_CTRL_EN_XY);
+    writeReg(REG_INT_STA, 0xFF);
+    writeReg(REG_INT_EN, INT_FIFO_TH);
+    writeReg(REG_INT_CTRL, INT_CTRL_GLOBAL);
+
+    armed = true;
+    irq.fall(callback(this, &TouchInput::onFall));
+    return true;
+}
+
+void TouchInput::fall(Callback<void()> handler) {
+    this->handler = handler;
+}
+
+void TouchInput::onFall() {
+    // Queued first, so the position is read before work the handler posts
+    queue->call(callback(this, &TouchInput::acknowledge));
+    if (armed) {
+        armed = false; // One report per tap
+        if (handler) {
+            handler();
+        }
+    }
+}
+
+/**
+ * @brief Thread context: reads the tap position, empties the FIFO and
+ * releases INT. While the finger is still down, only a lift (touch-detect
+ * change) may interrupt next; once it is up, the next sample is a new tap.
+ */
+void TouchInput::acknowledge() {
+    if (readReg(REG_FIFO_SIZE) > 0) {
+        char raw[4];
+        const char reg = REG_TSC_DATA_X;
+        i2c.write(stmpeAddress, &reg, 1, true);
+        i2c.read(stmpeAddress, raw, 4);
+        uint32_t rawX = ((uint8_t)raw[0] << 8) | (uint8_t)raw[1];
+        uint32_t rawY = ((uint8_t)raw[2] << 8) | (uint8_t)raw[3];
+        lastX = rawX * panelWidth / rawMax;
+        lastY = rawY * panelHeight / rawMax;
+    }
+    writeReg(REG_FIFO_STA, FIFO_STA_RESET);
+    writeReg(REG_FIFO_STA, 0);
+
+    if (readReg(REG_TSC_CTRL) & TSC_CTRL_STA) {
+        writeReg(REG_INT_EN, INT_TOUCH_DET); // Wait for the lift
+        writeReg(REG_INT_STA, 0xFF);
+        if (readReg(REG_TSC_CTRL) & TSC_CTRL_STA) {
+            return; // Still down; the lift interrupts and lands here again
+        }
+    }
+    writeReg(REG_INT_EN, INT_FIFO_TH);
+    writeReg(REG_INT_STA, 0xFF);
+    armed = true;
+}
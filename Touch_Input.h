@@ -0,0 +1,70 @@
+/**
+ * =====================================================
+ * Touch Input – STMPE811 touchscreen as a response key
+ * =====================================================
+ *
+ * The Discovery board's touch controller (STMPE811 on I2C3, PA8/PC9)
+ * pulls its INT line (PA15) low when the first touch sample reaches its
+ * FIFO. PA15 is also TIM2_CH1 (AF1), so with CaptureInput::Touch the
+ * capture timer latches that edge exactly like a BUTTON1 press: the tap
+ * is timestamped in hardware, without the button's travel and RC filter.
+ *
+ * The falling edge calls the handler at once (ISR). Everything that needs
+ * I2C — reading the position, emptying the FIFO, clearing the interrupt —
+ * is posted to an EventQueue and runs in thread context. A tap is
+ * reported once: until the finger has lifted, further INT edges are
+ * acknowledged but not passed on, so no separate debounce is needed.
+ *
+ * =====================================================
+ */
+
+#ifndef TOUCH_INPUT_H
+#define TOUCH_INPUT_H
+
+#include "mbed.h"
+
+class TouchInput {
+public:
+    TouchInput(PinName irq, PinName sda, PinName scl);
+
+    /**
+     * @brief Probes and configures the controller for low-latency touch
+     * detection. Thread context.
+     * @param queue Runs the I2C acknowledge after each interrupt.
+     * @return false if no STMPE811 answered.
+     */
+    bool init(EventQueue &queue);
+
+    /**
+     * @brief Attaches the handler for new taps (ISR context).
+     */
+    void fall(Callback<void()> handler);
+
+    /**
+     * @brief Position of the latest tap in LCD pixels (uncalibrated, from
+     * the raw 12-bit readings). Updated in thread context after the tap,
+     * before any queue event the handler posts for it runs.
+     */
+    uint16_t x() const {
+        return lastX;
+    }
+    uint16_t y() const {
+        return lastY;
+    }
+
+private:
+    void onFall();
+    void acknowledge();
+    bool writeReg(uint8_t reg, uint8_t value);
+    uint8_t readReg(uint8_t reg);
+
+    I2C i2c;
+    InterruptIn irq;
+    EventQueue *queue = nullptr;
+    Callback<void()> handler;
+    volatile bool armed = false;     // Next INT edge is a new tap
+    volatile uint16_t lastX = 0;
+    volatile uint16_t lastY = 0;
+};
+
+#endif // TOUCH_INPUT_H
@@ -0,0 +1,192 @@
+#include "Trial_Export.h"
+#include "Fixed_Format.h"
+#include "Ring_Buffer.h"
+
+// One DMA transfer: a binary frame or a CSV line
+struct ExportChunk {
+    uint8_t length;
+    uint8_t data[63];
+};
+
+// Big enough to batch the longest session plus its CSV header
+static RingBuffer<ExportChunk, 128> exportQueue;
+static ExportChunk txChunk;                   // Chunk currently owned by the DMA
+static std::atomic<bool> txBusy{false};       // True while a transfer is in flight
+
+// Monotonic chunk counters, each with a single writer. Chunks up to
+// releasedTotal may be sent; SessionEnd mode only releases on exportFlush().
+static uint32_t pushedTotal = 0;                 // Thread
+static std::atomic<uint32_t> releasedTotal{0};   // Thread
+static uint32_t sentTotal = 0;                   // Whoever owns txBusy
+static ExportConfig exportConfig;
+static uint32_t dropped = 0;
+static UnbufferedSerial *vcp = nullptr;
+static void (*commandHandler)(char) = nullptr;
+
+// USART1_TX request: DMA2 Stream 7, channel 4
+constexpr uint32_t txChannel = 4;
+constexpr uint32_t txFlags = DMA_HIFCR_CTCIF7 | DMA_HIFCR_CHTIF7 | DMA_HIFCR_CTEIF7 |
+                             DMA_HIFCR_CDMEIF7 | DMA_HIFCR_CFEIF7;
+
+uint16_t crc16(const uint8_t *data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief True while released chunks are still waiting to be sent.
+ */
+static bool txReleased() {
+    return sentTotal != releasedTotal.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Pops the next chunk and hands it to the DMA. The caller must own
+ * txBusy, which makes it the queue's only consumer at that moment.
+ */
+static void txStartNext() {
+    if (!txReleased() || !exportQueue.pop(txChunk)) {
+        txBusy.store(false);
+        // More may have been released after the check; reclaim it if nobody did
+        if (txReleased() && !txBusy.exchange(true)) {
+            txStartNext();
+        }
+        return;
+    }
+    sentTotal++;
+
+    DMA2->HIFCR = txFlags;
+    DMA2_Stream7->M0AR = (uint32_t)txChunk.data;
+    DMA2_Stream7->NDTR = txChunk.length;
+    DMA2_Stream7->CR |= DMA_SxCR_EN;
+}
+
+/**
+ * @brief Kicks the DMA if it is idle.
+ */
+static void txKick() {
+    if (!txBusy.exchange(true)) {
+        txStartNext();
+    }
+}
+
+static void txDmaIrq() {
+    DMA2->HIFCR = txFlags;
+    txStartNext(); // txBusy is still ours
+}
+
+static void queueChunk(const ExportChunk &chunk) {
+    if (!exportQueue.push(chunk)) {
+        dropped++;
+        return;
+    }
+    pushedTotal++;
+    if (exportConfig.mode == ExportMode::Continuous) {
+        releasedTotal.store(pushedTotal, std::memory_order_release);
+        txKick();
+    }
+}
+
+void exportInit(const ExportConfig &config) {
+    exportConfig = config;
+
+    // Let Mbed set up the pins and the baud rate, then take over TX with DMA
+    static UnbufferedSerial serial(USBTX, USBRX, config.baud);
+    vcp = &serial;
+
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
+    (void)RCC->AHB1ENR; // Let the clock enable settle
+
+    DMA2_Stream7->CR = 0;
+    DMA2_Stream7->PAR = (uint32_t)&USART1->DR;
+    DMA2_Stream7->CR = (txChannel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MINC | DMA_SxCR_DIR_0 |
+                       DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    USART1->CR3 |= USART_CR3_DMAT;
+
+    NVIC_SetVector(DMA2_Stream7_IRQn, (uint32_t)&txDmaIrq);
+    NVIC_EnableIRQ(DMA2_Stream7_IRQn);
+}
+
+void exportTrial(const TrialRecord &record, uint64_t onset_us) {
+    ExportChunk chunk;
+
+    if (exportConfig.format == ExportFormat::Csv) {
+        FormatBuffer line((char *)chunk.data, sizeof(chunk.data));
+        line.uint(record.index).chr(',').uint(record.foreperiod_us).chr(',').uint(record.reaction_us)
+            .chr(',').uint(record.flags).chr(',').uint(record.choice).chr(',')
+            .uint((uint32_t)(onset_us / 1000000)).chr(',').uint((uint32_t)(onset_us % 1000000)).text("\r\n");
+        chunk.length = line.length();
+    } else {
+        TrialFrame frame;
+        frame.sync[0] = 0xA5;
+        frame.sync[1] = 0x5A;
+        frame.version = 3;
+        frame.flags = record.flags;
+        frame.index = record.index;
+        frame.foreperiod_us = record.foreperiod_us;
+        frame.reaction_us = record.reaction_us;
+        frame.choice = record.choice;
+        frame.onset_us = onset_us;
+        frame.crc = crc16(&frame.version, offsetof(TrialFrame, crc) - offsetof(TrialFrame, version));
+        memcpy(chunk.data, &frame, sizeof(frame));
+        chunk.length = sizeof(frame);
+    }
+
+    queueChunk(chunk);
+}
+
+void exportSessionStart() {
+    if (exportConfig.format != ExportFormat::Csv) {
+        return;
+    }
+    static const char header[] = "index,foreperiod_us,reaction_us,flags,choice,onset_s,onset_us\r\n";
+    ExportChunk chunk;
+    memcpy(chunk.data, header, sizeof(header) - 1);
+    chunk.length = sizeof(header) - 1;
+    queueChunk(chunk);
+}
+
+void exportText(const char *text, size_t length) {
+    ExportChunk chunk;
+    while (length > 0) {
+        size_t n = (length < sizeof(chunk.data)) ? length : sizeof(chunk.data);
+        memcpy(chunk.data, text, n);
+        chunk.length = n;
+        queueChunk(chunk);
+        text += n;
+        length -= n;
+    }
+    exportFlush();
+}
+
+/**
+ * @brief USART1 RXNE: takes the byte (which clears the flag) and hands it on.
+ */
+static void rxIrq() {
+    char c;
+    vcp->read(&c, 1);
+    if (commandHandler) {
+        commandHandler(c);
+    }
+}
+
+void exportOnCommand(void (*handler)(char)) {
+    commandHandler = handler;
+    // An attached RX interrupt holds Mbed's deep-sleep lock; detaching releases it
+    vcp->attach(handler ? callback(&rxIrq) : Callback<void()>(), SerialBase::RxIrq);
+}
+
+void exportFlush() {
+    releasedTotal.store(pushedTotal, std::memory_order_release);
+    txKick();
+}
+
+uint32_t exportDropped() {
+    return dropped;
+}
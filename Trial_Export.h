@@ -0,0 +1,125 @@
+/**
+ * =====================================================
+ * Trial Export – streaming results over the ST-LINK VCP
+ * =====================================================
+ *
+ * Sends every TrialRecord over USART1 (PA9/PA10, the ST-LINK virtual COM
+ * port). Transmission is DMA-driven (DMA2 Stream 7, channel 4): the caller
+ * only formats a chunk into a queue, and the DMA completion interrupt
+ * starts the next one. Nothing on this path ever waits for the UART.
+ *
+ * Binary frame (25 bytes, little-endian):
+ *
+ *   offset  size  field
+ *   0       2     sync 0xA5 0x5A
+ *   2       1     version (3)
+ *   3       1     flags (TRIAL_* bits)
+ *   4       2     trial index
+ *   6       4     foreperiod, µs
+ *   10      4     reaction time, µs
+ *   14      1     choice: stimulus (low nibble), response (high nibble)
+ *   15      8     stimulus onset, RTC wall clock, µs since the Unix epoch
+ *   23      2     CRC-16/CCITT-FALSE over bytes 2..22
+ *
+ * The onset stamp lets trials from several units, with their RTCs set to
+ * the same clock, be merged onto one timeline.
+ *
+ * CSV mode sends "index,foreperiod_us,reaction_us,flags,choice,onset_s,
+ * onset_us" lines instead (onset split into seconds and microseconds),
+ * with a header line at the start of each session, for debugging in a
+ * terminal.
+ *
+ * Continuous mode sends each trial as it is logged; SessionEnd mode holds
+ * the session's chunks and sends them in one batch on exportFlush().
+ *
+ * Text sent with exportText() (diagnostic dumps) shares the same queue and
+ * goes out between frames; binary readers resynchronise on sync and CRC.
+ * Bytes received on the port are passed to an optional command handler.
+ *
+ * =====================================================
+ */
+
+#ifndef TRIAL_EXPORT_H
+#define TRIAL_EXPORT_H
+
+#include "Trial_Record.h"
+#include "mbed.h"
+
+enum class ExportFormat : uint8_t {
+    Binary,
+    Csv,
+};
+
+enum class ExportMode : uint8_t {
+    Continuous,   // Send each trial as soon as it is logged
+    SessionEnd,   // Batch the whole session, send on exportFlush()
+};
+
+struct ExportConfig {
+    ExportFormat format;
+    ExportMode mode;
+    int baud;
+};
+
+MBED_PACKED(struct) TrialFrame {
+    uint8_t sync[2];
+    uint8_t version;
+    uint8_t flags;
+    uint16_t index;
+    uint32_t foreperiod_us;
+    uint32_t reaction_us;
+    uint8_t choice;
+    uint64_t onset_us;
+    uint16_t crc;
+};
+
+static_assert(sizeof(TrialFrame) == 25, "TrialFrame layout changed; bump the version");
+
+/**
+ * @brief Configures USART1 and its TX DMA stream.
+ */
+void exportInit(const ExportConfig &config);
+
+/**
+ * @brief Queues one trial for sending. Thread context, single caller.
+ * @param onset_us Wall-clock time of the stimulus onset (timebaseWall()).
+ */
+void exportTrial(const TrialRecord &record, uint64_t onset_us);
+
+/**
+ * @brief Marks the start of a session (CSV header line).
+ */
+void exportSessionStart();
+
+/**
+ * @brief Starts sending everything queued. Called at session end; in
+ * Continuous mode it only kicks anything still pending.
+ */
+void exportFlush();
+
+/**
+ * @brief Queues ASCII text, split into as many chunks as it needs, and
+ * sends it right away (in SessionEnd mode this also releases the batch
+ * held so far). Thread context, same caller as exportTrial().
+ */
+void exportText(const char *text, size_t length);
+
+/**
+ * @brief Attaches a handler for each byte received on the port. Called in
+ * interrupt context. While one is attached the MCU cannot enter STOP mode
+ * (Mbed keeps the UART clocked); nullptr detaches it. Safe from interrupt
+ * context.
+ */
+void exportOnCommand(void (*handler)(char));
+
+/**
+ * @brief Chunks lost because the export queue was full.
+ */
+uint32_t exportDropped();
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF).
+ */
+uint16_t crc16(const uint8_t *data, size_t length);
+
+#endif // TRIAL_EXPORT_H
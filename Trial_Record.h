@@ -0,0 +1,39 @@
+/**
+ * =====================================================
+ * Trial Record – raw per-trial data
+ * =====================================================
+ *
+ * One record is produced by the press ISR for every trial, valid or not,
+ * and carried through the trial log to the deferred thread.
+ *
+ * The layout fills exactly 12 bytes; Flash_Store relies on that.
+ *
+ * =====================================================
+ */
+
+#ifndef TRIAL_RECORD_H
+#define TRIAL_RECORD_H
+
+#include <stdint.h>
+
+// TrialRecord::flags bits
+constexpr uint8_t TRIAL_EARLY = 1U << 0;          // Pressed during the foreperiod
+constexpr uint8_t TRIAL_CALIBRATION = 1U << 1;    // Synthetic press from the self-test
+constexpr uint8_t TRIAL_TOUCH = 1U << 2;          // Response was a touchscreen tap
+constexpr uint8_t TRIAL_WRONG = 1U << 3;          // Choice reaction: response did not match the stimulus
+constexpr uint8_t TRIAL_ANTICIPATION = 1U << 4;   // Faster than the validation floor
+constexpr uint8_t TRIAL_LAPSE = 1U << 5;          // Slower than the validation ceiling
+constexpr uint8_t TRIAL_OUTLIER = 1U << 6;        // Far from the session median (MAD test)
+
+// Any of these keeps a trial out of the personal best and the statistics
+constexpr uint8_t TRIAL_EXCLUDED = TRIAL_EARLY | TRIAL_WRONG | TRIAL_ANTICIPATION | TRIAL_LAPSE | TRIAL_OUTLIER;
+
+struct TrialRecord {
+    uint32_t foreperiod_us;  // Random delay before the stimulus
+    uint32_t reaction_us;    // Stimulus → press; 0 for an early press; raw (uncorrected) for calibration
+    uint16_t index;          // Trial number within the session, from 0
+    uint8_t flags;           // TRIAL_* bits
+    uint8_t choice;          // Choice reaction: stimulus (low nibble), response (high nibble)
+};
+
+#endif // TRIAL_RECORD_H
@@ -0,0 +1,67 @@
+/**
+ * =====================================================
+ * Trial Validation – plausibility checks on a captured reaction time
+ * =====================================================
+ *
+ * Runs after capture, before a trial reaches the personal best or any
+ * statistic. Three checks, each with its own TrialRecord flag:
+ *   Anticipation – faster than floor_us. Too fast for a response to the
+ *                  stimulus, so the press was a guess that happened to land
+ *                  after it.
+ *   Lapse        – slower than ceiling_us; attention was elsewhere.
+ *   Outlier      – within the limits, but far from this session's other
+ *                  trials: the robust z-score |x − median| / (1.4826 · MAD)
+ *                  exceeds outlierScore. Judged once outlierMinTrials
+ *                  trials are in the window.
+ *
+ * Flagged trials are still logged, exported and stored.
+ *
+ * All values are in microseconds.
+ *
+ * =====================================================
+ */
+
+#ifndef TRIAL_VALIDATION_H
+#define TRIAL_VALIDATION_H
+
+#include "Session_Stats.h"
+#include "Trial_Record.h"
+
+struct ValidationConfig {
+    uint32_t floor_us;          // Faster is an anticipation
+    uint32_t ceiling_us;        // Slower is a lapse
+    float outlierScore;         // Robust z-score limit; 0 turns the check off
+    uint32_t outlierMinTrials;  // Window fill before outliers are judged
+};
+
+/**
+ * @brief Checks one reaction time and returns its TRIAL_ANTICIPATION,
+ * TRIAL_LAPSE or TRIAL_OUTLIER flag (0 if it passes). Times within the
+ * limits join the window, outliers included: the median and MAD shrug
+ * them off, and a genuine change of pace is followed instead of rejected
+ * for the rest of the session.
+ */
+template <uint32_t N>
+uint8_t validateTrial(const ValidationConfig &config, MedianWindow<N> &window, uint32_t us) {
+    if (us < config.floor_us) {
+        return TRIAL_ANTICIPATION;
+    }
+    if (us > config.ceiling_us) {
+        return TRIAL_LAPSE;
+    }
+
+    uint8_t flags = 0;
+    if (config.outlierScore > 0.0f && window.size() >= config.outlierMinTrials) {
+        uint32_t median = window.median();
+        uint32_t mad = window.mad();
+        uint32_t deviation = (us > median) ? us - median : median - us;
+        // 1.4826 · MAD estimates the SD of normally distributed data
+        if (mad > 0 && (float)deviation > config.outlierScore * 1.4826f * (float)mad) {
+            flags = TRIAL_OUTLIER;
+        }
+    }
+    window.add(us);
+    return flags;
+}
+
+#endif // TRIAL_VALIDATION_H
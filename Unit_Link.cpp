@@ -0,0 +1,311 @@
+#include "Unit_Link.h"
+#include "Ring_Buffer.h"
+#include "Trial_Export.h"
+
+constexpr uint8_t typeBeacon = 'B';
+constexpr uint8_t typeBatch = 'D';
+
+MBED_PACKED(struct) LinkHeader {
+    uint8_t sync[2];     // 0xA5 0x5B
+    uint8_t type;
+    uint8_t unit;        // Sender; 0 for the collector
+    uint16_t seq;        // Beacon: cycle count; batch: sequence number
+    uint8_t count;       // Beacon: units; batch: trials
+};
+
+constexpr uint32_t beaconMax = sizeof(LinkHeader) + linkMaxUnits * sizeof(uint16_t) + sizeof(uint16_t);
+constexpr uint32_t batchMax = sizeof(LinkHeader) + linkBatchTrials * sizeof(LinkTrial) + sizeof(uint16_t);
+constexpr uint32_t frameMax = (beaconMax > batchMax) ? beaconMax : batchMax;
+
+// A batch accepted by the collector, on its way to the queue
+struct InboundBatch {
+    uint8_t unit;
+    uint8_t count;
+    LinkTrial trials[linkBatchTrials];
+};
+
+static LinkConfig linkConfig;
+static EventQueue *queue = nullptr;
+static DigitalOut *driver = nullptr;         // Transceiver DE and /RE
+static void (*trialHandler)(uint8_t unit, const LinkTrial &trial) = nullptr;
+static uint32_t dropped = 0;
+
+static uint8_t rxBuffer[frameMax + 1];       // One spare byte shows up an oversized frame
+static uint8_t txBuffer[frameMax];           // Owned by the sender until its DMA is done
+static uint32_t txLength = 0;
+
+// Unit: trials waiting for a batch (thread → slot ISR), the batch in
+// flight and the collector's latest acknowledgement (UART ISR → slot ISR)
+static RingBuffer<LinkTrial, 64> pending;
+static Timeout slotTimeout;
+static uint16_t txSeq = 0;
+static bool sealed = false;                  // txBuffer holds batch txSeq, not yet acknowledged
+static bool synced = false;                  // txSeq taken from a beacon
+static std::atomic<uint16_t> lastAck{0};
+
+// Collector: last sequence number accepted per unit (0: none yet), and
+// accepted batches for the queue (UART ISR → thread)
+static volatile uint16_t acks[linkMaxUnits];
+static RingBuffer<InboundBatch, 16> inbound;
+static Ticker beaconTicker;
+static uint16_t cycle = 0;
+
+// UART5_RX: DMA1 Stream 0, UART5_TX: DMA1 Stream 7, both channel 4
+constexpr uint32_t dmaChannel = 4;
+constexpr uint32_t rxFlags = DMA_LIFCR_CTCIF0 | DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTEIF0 |
+                             DMA_LIFCR_CDMEIF0 | DMA_LIFCR_CFEIF0;
+constexpr uint32_t txFlags = DMA_HIFCR_CTCIF7 | DMA_HIFCR_CHTIF7 | DMA_HIFCR_CTEIF7 |
+                             DMA_HIFCR_CDMEIF7 | DMA_HIFCR_CFEIF7;
+
+// Below the capture timer, the buttons and Mbed's ticker (all at 0)
+constexpr uint32_t linkPriority = 8;
+
+static void rxArm() {
+    DMA1->LIFCR = rxFlags;
+    DMA1_Stream0->M0AR = (uint32_t)rxBuffer;
+    DMA1_Stream0->NDTR = sizeof(rxBuffer);
+    DMA1_Stream0->CR |= DMA_SxCR_EN;
+}
+
+/**
+ * @brief Drives the bus and sends txBuffer. The transceiver is released
+ * once the last stop bit is out (USART TC).
+ */
+static void txStart(uint32_t length) {
+    *driver = 1;
+    DMA1->HIFCR = txFlags;
+    DMA1_Stream7->M0AR = (uint32_t)txBuffer;
+    DMA1_Stream7->NDTR = length;
+    DMA1_Stream7->CR |= DMA_SxCR_EN;
+}
+
+static uint16_t frameCrc(const uint8_t *frame, uint32_t length) {
+    return crc16(frame + 2, length - 2);
+}
+
+/**
+ * @brief Adds the CRC to the frame in txBuffer.
+ * @return Frame length including the CRC.
+ */
+static uint32_t txSeal(uint32_t length) {
+    uint16_t crc = frameCrc(txBuffer, length);
+    memcpy(txBuffer + length, &crc, sizeof(crc));
+    return length + sizeof(crc);
+}
+
+// ---- Unit ----
+
+/**
+ * @brief Seals the next batch from the pending trials into txBuffer.
+ * @return false if no trial is waiting.
+ */
+static bool sealBatch() {
+    LinkHeader header = { {0xA5, 0x5B}, typeBatch, linkConfig.unit, 0, 0 };
+    LinkTrial *trials = (LinkTrial *)(txBuffer + sizeof(header));
+    while (header.count < linkBatchTrials && pending.pop(trials[header.count])) {
+        header.count++;
+    }
+    if (header.count == 0) {
+        return false;
+    }
+    if (++txSeq == 0) {
+        txSeq = 1; // 0 means "nothing accepted yet"
+    }
+    header.seq = txSeq;
+    memcpy(txBuffer, &header, sizeof(header));
+    txLength = txSeal(sizeof(header) + header.count * sizeof(LinkTrial));
+    sealed = true;
+    return true;
+}
+
+/**
+ * @brief Slot timeout: sends the unacknowledged batch again, or the next
+ * one once the collector has taken it.
+ */
+static void slotStart() {
+    if (!synced) {
+        txSeq = lastAck.load();
+        synced = true;
+    }
+    if (sealed && lastAck.load() == txSeq) {
+        sealed = false;
+    }
+    if (sealed || sealBatch()) {
+        txStart(txLength);
+    }
+}
+
+static void beaconReceived(const LinkHeader &header, const uint8_t *body) {
+    if (linkConfig.unit == 0 || linkConfig.unit > header.count) {
+        return; // No slot for this unit in this cycle
+    }
+    uint16_t ack;
+    memcpy(&ack, body + (linkConfig.unit - 1) * sizeof(ack), sizeof(ack));
+    lastAck.store(ack);
+    slotTimeout.attach(&slotStart, std::chrono::microseconds(linkGap_us + (linkConfig.unit - 1) * linkSlot_us));
+}
+
+// ---- Collector ----
+
+static void drainInbound() {
+    InboundBatch batch;
+    while (inbound.pop(batch)) {
+        for (uint32_t i = 0; i < batch.count; i++) {
+            if (trialHandler) {
+                trialHandler(batch.unit, batch.trials[i]);
+            }
+        }
+    }
+}
+
+static void batchReceived(const LinkHeader &header, const uint8_t *body) {
+    if (header.unit == 0 || header.unit > linkMaxUnits || header.count > linkBatchTrials) {
+        return;
+    }
+    uint16_t &ack = const_cast<uint16_t &>(acks[header.unit - 1]);
+    if (header.seq == ack) {
+        return; // Our acknowledgement was lost: already merged, ack again
+    }
+    InboundBatch batch;
+    batch.unit = header.unit;
+    batch.count = header.count;
+    memcpy(batch.trials, body, header.count * sizeof(LinkTrial));
+    if (!inbound.push(batch)) {
+        return; // No acknowledgement either: the unit sends it again
+    }
+    ack = header.seq;
+    queue->call(&drainInbound);
+}
+
+/**
+ * @brief Beacon ticker, every cycle: sends the beacon with the
+ * acknowledgements so far. Runs from the ticker interrupt rather than the
+ * queue, so the units' slots are not shifted by whatever else the queue
+ * is busy with; like slotStart() it only starts a DMA transfer.
+ */
+static void sendBeacon() {
+    LinkHeader header = { {0xA5, 0x5B}, typeBeacon, 0, ++cycle, linkConfig.units };
+    memcpy(txBuffer, &header, sizeof(header));
+    for (uint32_t i = 0; i < linkConfig.units; i++) {
+        uint16_t ack = acks[i];
+        memcpy(txBuffer + sizeof(header) + i * sizeof(ack), &ack, sizeof(ack));
+    }
+    txStart(txSeal(sizeof(header) + linkConfig.units * sizeof(uint16_t)));
+}
+
+// ---- Interrupts ----
+
+/**
+ * @brief Checks sync, length and CRC of a received frame and passes it on
+ * by type. Frames for the other role (and this unit's own) are ignored.
+ */
+static void frameReceived(uint32_t length) {
+    LinkHeader header;
+    if (length < sizeof(header) + sizeof(uint16_t) || length > frameMax) {
+        return;
+    }
+    memcpy(&header, rxBuffer, sizeof(header));
+    uint32_t item = (header.type == typeBeacon) ? sizeof(uint16_t) : sizeof(LinkTrial);
+    uint16_t crc;
+    memcpy(&crc, rxBuffer + length - sizeof(crc), sizeof(crc));
+    if (header.sync[0] != 0xA5 || header.sync[1] != 0x5B ||
+        length != sizeof(header) + header.count * item + sizeof(crc) ||
+        crc != frameCrc(rxBuffer, length - sizeof(crc))) {
+        dropped += (linkConfig.role == LinkRole::Collector);
+        return;
+    }
+
+    const uint8_t *body = rxBuffer + sizeof(header);
+    if (header.type == typeBeacon && linkConfig.role == LinkRole::Unit) {
+        beaconReceived(header, body);
+    } else if (header.type == typeBatch && linkConfig.role == LinkRole::Collector) {
+        batchReceived(header, body);
+    }
+}
+
+/**
+ * @brief UART5: IDLE ends a received frame; TC ends a transmission.
+ */
+static void uartIrq() {
+    uint32_t sr = UART5->SR;
+    if ((sr & USART_SR_TC) && (UART5->CR1 & USART_CR1_TCIE)) {
+        UART5->CR1 &= ~USART_CR1_TCIE;
+        *driver = 0; // Last stop bit is out: release the bus
+    }
+    if (sr & (USART_SR_IDLE | USART_SR_ORE | USART_SR_FE | USART_SR_NE)) {
+        (void)UART5->DR; // SR then DR read clears them
+        DMA1_Stream0->CR &= ~DMA_SxCR_EN;
+        while (DMA1_Stream0->CR & DMA_SxCR_EN) {
+        }
+        uint32_t length = sizeof(rxBuffer) - DMA1_Stream0->NDTR;
+        if (sr & USART_SR_IDLE) {
+            frameReceived(length);
+        }
+        rxArm();
+    }
+}
+
+static void txDmaIrq() {
+    DMA1->HIFCR = txFlags;
+    UART5->SR = ~USART_SR_TC;
+    UART5->CR1 |= USART_CR1_TCIE;
+}
+
+// ---- API ----
+
+void linkInit(const LinkConfig &config, EventQueue &eventQueue) {
+    linkConfig = config;
+    queue = &eventQueue;
+    if (config.role == LinkRole::Off) {
+        return;
+    }
+
+    // Pins and baud rate through Mbed, then TX and RX go to DMA
+    static UnbufferedSerial serial(PC_12, PD_2, config.baud);
+    static DigitalOut de(config.driverEnable, 0);
+    driver = &de;
+
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;
+    (void)RCC->AHB1ENR; // Let the clock enable settle
+
+    DMA1_Stream7->CR = 0;
+    DMA1_Stream7->PAR = (uint32_t)&UART5->DR;
+    DMA1_Stream7->CR = (dmaChannel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MINC | DMA_SxCR_DIR_0 | DMA_SxCR_TCIE;
+    DMA1_Stream0->CR = 0;
+    DMA1_Stream0->PAR = (uint32_t)&UART5->DR;
+    DMA1_Stream0->CR = (dmaChannel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MINC;
+    rxArm();
+    UART5->CR3 |= USART_CR3_DMAT | USART_CR3_DMAR | USART_CR3_EIE;
+    UART5->CR1 |= USART_CR1_IDLEIE;
+
+    NVIC_SetVector(DMA1_Stream7_IRQn, (uint32_t)&txDmaIrq);
+    NVIC_SetPriority(DMA1_Stream7_IRQn, linkPriority);
+    NVIC_EnableIRQ(DMA1_Stream7_IRQn);
+    NVIC_SetVector(UART5_IRQn, (uint32_t)&uartIrq);
+    NVIC_SetPriority(UART5_IRQn, linkPriority);
+    NVIC_EnableIRQ(UART5_IRQn);
+
+    if (config.role == LinkRole::Collector) {
+        sleep_manager_lock_deep_sleep(); // The bus runs on through Dormant
+        beaconTicker.attach(&sendBeacon, config.cycle);
+    }
+}
+
+void linkTrial(uint8_t profile, const TrialRecord &record) {
+    LinkTrial trial = { profile, record.flags, record.index, record.reaction_us };
+    if (linkConfig.role == LinkRole::Collector) {
+        if (trialHandler) {
+            trialHandler(0, trial);
+        }
+    } else if (linkConfig.role == LinkRole::Unit && !pending.push(trial)) {
+        dropped++;
+    }
+}
+
+void linkOnTrial(void (*handler)(uint8_t unit, const LinkTrial &trial)) {
+    trialHandler = handler;
+}
+
+uint32_t linkDropped() {
+    return dropped;
+}
@@ -0,0 +1,108 @@
+/**
+ * =====================================================
+ * Unit Link – multi-unit result aggregation over RS-485
+ * =====================================================
+ *
+ * Several testers share one half-duplex RS-485 bus on UART5 (PC12 TX,
+ * PD2 RX, a transceiver with DE and /RE tied to one GPIO). One of them is
+ * the collector; every other unit has an id from 1 to the number of
+ * units on the bus.
+ *
+ * The collector sends a beacon every cycle. Each unit's time slot starts
+ * a fixed offset after the beacon ends, so units never poll and never
+ * collide, and adding a unit only adds one slot:
+ *
+ *   | beacon | gap | slot 1 | slot 2 | ... | slot N |   idle   | beacon |
+ *
+ * A unit queues a compact LinkTrial for every trial. In its slot it sends
+ * one batch frame of up to linkBatchTrials of them, with a 16-bit
+ * sequence number. The beacon carries, for each unit, the sequence number
+ * of the last batch the collector accepted. The unit keeps sending the
+ * same batch in each slot until the beacon acknowledges it, then seals the
+ * next one from whatever has queued up meanwhile. A lost batch or beacon
+ * costs one cycle; a duplicate is acknowledged again and dropped.
+ *
+ *   beacon: A5 5B | 'B' | 0 | cycle | units | ack[units] (u16)  | CRC-16
+ *   batch:  A5 5B | 'D' | id | seq  | count | LinkTrial[count]  | CRC-16
+ *
+ * (little-endian; CRC-16/CCITT-FALSE from the type byte on.) A unit
+ * takes its first sequence number from the first beacon it hears, so a
+ * reboot on either side never looks like a duplicate.
+ *
+ * Nothing here touches the capture path. Trials are queued from thread
+ * context; frames are received by DMA and parsed on the UART IDLE
+ * interrupt; a unit's retransmission is just its slot timeout restarting
+ * the TX DMA; the collector's beacon is a Ticker of its own, so it keeps
+ * its period whatever the thread queues are doing, and its merging runs
+ * on the EventQueue passed to linkInit(). The UART and DMA interrupts run
+ * below the capture and button priorities, and the slot timeout and the
+ * beacon tick do no more than start a DMA transfer.
+ *
+ * =====================================================
+ */
+
+#ifndef UNIT_LINK_H
+#define UNIT_LINK_H
+
+#include "Trial_Record.h"
+#include "mbed.h"
+
+constexpr uint32_t linkMaxUnits = 32;       // Ids 1–32, one slot each
+constexpr uint32_t linkBatchTrials = 8;     // Trials per batch frame
+constexpr uint32_t linkSlot_us = 1000;      // Longest batch (73 bytes at 1 Mbaud) plus guard
+constexpr uint32_t linkGap_us = 200;        // Beacon end to slot 1: turnaround time
+
+enum class LinkRole : uint8_t {
+    Off,        // No bus
+    Unit,       // Sends its trials in its slot
+    Collector,  // Beacons and merges every unit's trials
+};
+
+struct LinkConfig {
+    LinkRole role;
+    uint8_t unit;        // Unit: its id, 1..units
+    uint8_t units;       // Slots per cycle
+    int baud;
+    PinName driverEnable;
+    std::chrono::milliseconds cycle; // Collector: beacon period
+};
+
+// One trial on the bus
+MBED_PACKED(struct) LinkTrial {
+    uint8_t profile;
+    uint8_t flags;       // TRIAL_* bits
+    uint16_t index;
+    uint32_t reaction_us;
+};
+
+static_assert(sizeof(LinkTrial) == 8, "LinkTrial layout changed");
+
+/**
+ * @brief Configures UART5 and its DMA streams for the role. Thread
+ * context. A collector also keeps the MCU out of STOP mode, so the bus
+ * keeps its beacon through the units' Dormant periods.
+ * @param queue Collector: runs the trial handler.
+ */
+void linkInit(const LinkConfig &config, EventQueue &queue);
+
+/**
+ * @brief Queues one trial. On a collector the trial is merged at once as
+ * unit 0's. Thread context, single caller.
+ */
+void linkTrial(uint8_t profile, const TrialRecord &record);
+
+/**
+ * @brief Collector: attaches the handler for every trial accepted from
+ * the bus (and the collector's own, as unit 0), in arrival order, with
+ * the id of the unit it came from. Profile indices are per unit. Runs on
+ * the queue passed to linkInit().
+ */
+void linkOnTrial(void (*handler)(uint8_t unit, const LinkTrial &trial));
+
+/**
+ * @brief Unit: trials dropped because the queue was full (bus down for
+ * longer than the queue lasts). Collector: frames with a bad CRC.
+ */
+uint32_t linkDropped();
+
+#endif // UNIT_LINK_H
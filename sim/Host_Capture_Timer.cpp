@@ -0,0 +1,32 @@
+// TIM2 capture on the virtual clock: the first press edge on the captured pin
+// after captureTimerArm() is latched exactly, as by the one-shot DMA.
+#include "Capture_Timer.h"
+
+volatile uint32_t captureTimerLatched = 0;
+static PinName capturePin = BUTTON1;
+constexpr uint32_t isrEntry_us = 2;
+
+void captureTimerInit(uint8_t filter, CaptureInput input) {
+    (void)filter;
+    capturePin = (input == CaptureInput::Touch) ? PA_15 : BUTTON1;
+    sim::armCapture(capturePin, capturePin == BUTTON1); // BUTTON1 active high, touch INT active low
+}
+
+void captureTimerArm() {
+    sim::armCapture(capturePin, capturePin == BUTTON1);
+}
+
+uint32_t captureTimerNow() {
+    return (uint32_t)sim::now();
+}
+
+uint32_t captureTimerPress() {
+    uint32_t time;
+    if (sim::captured(time)) {
+        captureTimerLatched = time;
+        return time;
+    }
+    // No edge latched: the target reads TIM2 in the ISR a few µs after the
+    // edge, so a missed latch shows up as a timing error here too
+    return captureTimerNow() + isrEntry_us;
+}
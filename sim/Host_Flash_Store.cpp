@@ -0,0 +1,75 @@
+// Flash store in RAM: same API, the history keeps the newest
+// storeKeptTrials trials, writes complete at once.
+#include "Flash_Store.h"
+
+static ProfileSummary summaries[storeProfiles];
+static constexpr ProfileSummary emptySummary = { UINT32_MAX, 0, 0, 0 };
+
+struct StoredTrial {
+    uint8_t profile;
+    TrialRecord record;
+};
+static StoredTrial history[storeKeptTrials];
+static uint32_t historyTotal = 0;
+static uint32_t params[storeParams];
+static uint32_t paramsSet = 0;
+
+void storeInit() {
+    for (ProfileSummary &summary : summaries) {
+        summary = emptySummary;
+    }
+    historyTotal = 0;
+}
+
+const ProfileSummary &storeProfile(uint8_t profile) {
+    return (profile < storeProfiles) ? summaries[profile] : emptySummary;
+}
+
+void storeRecordProfile(uint8_t profile, const ProfileSummary &summary) {
+    if (profile < storeProfiles) {
+        summaries[profile] = summary;
+    }
+}
+
+bool storeParam(uint8_t key, uint32_t &value) {
+    if (key >= storeParams || !(paramsSet & (1UL << key))) {
+        return false;
+    }
+    value = params[key];
+    return true;
+}
+
+void storeRecordParam(uint8_t key, uint32_t value) {
+    if (key < storeParams) {
+        params[key] = value;
+        paramsSet |= 1UL << key;
+    }
+}
+
+void storeClearParam(uint8_t key) {
+    if (key < storeParams) {
+        paramsSet &= ~(1UL << key);
+    }
+}
+
+void storeRecordTrial(uint8_t profile, const TrialRecord &record) {
+    history[historyTotal % storeKeptTrials] = { profile, record };
+    historyTotal++;
+}
+
+bool storeService(bool mayErase) {
+    (void)mayErase;
+    return false;
+}
+
+void storeForEachTrial(void (*visit)(uint8_t profile, const TrialRecord &record)) {
+    uint32_t kept = (historyTotal < storeKeptTrials) ? historyTotal : storeKeptTrials;
+    for (uint32_t i = historyTotal - kept; i < historyTotal; i++) {
+        const StoredTrial &trial = history[i % storeKeptTrials];
+        visit(trial.profile, trial.record);
+    }
+}
+
+uint32_t storeDropped() {
+    return 0;
+}
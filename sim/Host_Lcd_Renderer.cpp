@@ -0,0 +1,172 @@
+// Headless renderer: one ARGB8888 framebuffer in RAM plus the character in
+// every glyph cell, so a run can be checked by what the panel would show.
+// rendererPresent() waits in virtual time for the next 60 Hz vertical
+// blanking. An overlay shown by rendererOverlay() reports its first line
+// from an interrupt, that far into the following frame, as on the target.
+#include "Lcd_Renderer.h"
+#include <string>
+#include <vector>
+
+constexpr uint32_t screenWidth = 240;
+constexpr uint32_t screenHeight = 320;
+constexpr uint64_t framePeriod_us = 16667;
+constexpr uint32_t frameLines = 328; // Active lines plus blanking
+constexpr uint32_t textColumns = screenWidth / 7 + 1;
+
+static uint32_t framebuffer[screenWidth * screenHeight];
+static char text[screenHeight][textColumns + 1];   // Glyph cell at pixel row y, column
+static std::vector<std::string> bitmaps;           // Pre-rendered labels (fills: empty) by address - 1
+static uint16_t glyphW = 7;
+static uint16_t glyphH = 12;
+static void (*scanHook)() = nullptr;
+static uint64_t overlayGeneration = 0; // Newer show/hide calls cancel pending scans
+static uint32_t frames = 0;
+
+static void fill(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t color) {
+    if (x >= screenWidth || y >= screenHeight) {
+        return;
+    }
+    w = (x + w > screenWidth) ? screenWidth - x : w;
+    h = (y + h > screenHeight) ? screenHeight - y : h;
+    for (uint32_t row = y; row < y + h; row++) {
+        uint32_t *p = &framebuffer[row * screenWidth + x];
+        for (uint32_t i = 0; i < w; i++) {
+            p[i] = color;
+        }
+    }
+}
+
+static void eraseText(uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+    for (uint32_t row = y; row < y + h && row < screenHeight; row++) {
+        for (uint32_t col = x / glyphW; col < (x + w + glyphW - 1) / glyphW && col < textColumns; col++) {
+            text[row][col] = ' ';
+        }
+    }
+}
+
+void rendererInit(LCD_DISCO_F429ZI &lcd, sFONT *font) {
+    (void)lcd;
+    glyphW = font->Width;
+    glyphH = font->Height;
+    rendererClear(LCD_COLOR_WHITE);
+}
+
+void rendererClear(uint32_t color) {
+    fill(0, 0, screenWidth, screenHeight, color);
+    eraseText(0, 0, screenWidth, screenHeight);
+}
+
+void rendererFillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t color) {
+    fill(x, y, w, h, color);
+    eraseText(x, y, w, h);
+}
+
+void rendererGlyph(uint16_t x, uint16_t y, char c, uint32_t fg, uint32_t bg) {
+    if (x + glyphW > screenWidth || y + glyphH > screenHeight) {
+        return;
+    }
+    fill(x, y, glyphW, glyphH, bg);
+    if (c != ' ') {
+        fill(x + 1, y + 2, glyphW - 2, glyphH - 4, fg); // A solid block stands in for the glyph
+    }
+    text[y][x / glyphW] = c;
+}
+
+uint16_t rendererText(uint16_t x, uint16_t y, const char *s, uint32_t fg, uint32_t bg) {
+    for (; *s != '\0' && x + glyphW <= screenWidth; s++) {
+        rendererGlyph(x, y, *s, fg, bg);
+        x += glyphW;
+    }
+    return x;
+}
+
+RendererBitmap rendererRenderText(const char *s, uint32_t fg, uint32_t bg) {
+    (void)fg;
+    (void)bg;
+    bitmaps.emplace_back(s);
+    return { (uint32_t)bitmaps.size(), (uint16_t)(bitmaps.back().size() * glyphW), glyphH };
+}
+
+RendererBitmap rendererRenderFill(uint16_t w, uint16_t h, uint32_t color) {
+    (void)color;
+    bitmaps.emplace_back();
+    return { (uint32_t)bitmaps.size(), w, h };
+}
+
+void rendererBlit(const RendererBitmap &bitmap, uint16_t x, uint16_t y) {
+    if (bitmap.address == 0 || bitmap.address > bitmaps.size()) {
+        return;
+    }
+    rendererText(x, y, bitmaps[bitmap.address - 1].c_str(), LCD_COLOR_DARKBLUE, LCD_COLOR_WHITE);
+}
+
+void rendererPresent() {
+    bool swapped = false;
+    uint64_t vblank = (sim::now() / framePeriod_us + 1) * framePeriod_us;
+    sim::schedule(vblank, [&swapped] { swapped = true; });
+    while (!swapped) {
+        sim::step(); // The display thread sleeps; everything else runs
+    }
+    frames++;
+}
+
+void rendererOverlay(const RendererBitmap *bitmap, uint16_t x, uint16_t y) {
+    (void)x;
+    uint64_t shown = ++overlayGeneration;
+    if (bitmap == nullptr || bitmap->address == 0) {
+        return;
+    }
+    uint64_t vblank = (sim::now() / framePeriod_us + 1) * framePeriod_us;
+    sim::schedule(vblank + y * framePeriod_us / frameLines, [shown] {
+        if (shown == overlayGeneration && scanHook) {
+            scanHook();
+        }
+    });
+}
+
+void rendererOnOverlayScan(void (*hook)()) {
+    scanHook = hook;
+}
+
+void rendererSuspend() {
+}
+
+void rendererResume() {
+}
+
+uint16_t rendererGlyphWidth() {
+    return glyphW;
+}
+
+uint16_t rendererGlyphHeight() {
+    return glyphH;
+}
+
+namespace sim {
+
+const char *screenText(uint16_t y) {
+    static char row[textColumns + 1];
+    uint32_t end = 0;
+    for (uint32_t col = 0; col < textColumns; col++) {
+        row[col] = text[y][col] ? text[y][col] : ' ';
+        if (row[col] != ' ') {
+            end = col + 1;
+        }
+    }
+    row[end] = '\0';
+    return row;
+}
+
+uint32_t framesPresented() {
+    return frames;
+}
+
+uint32_t framebufferChecksum() {
+    uint32_t sum = 0;
+    for (uint32_t pixel : framebuffer) {
+        sum = sum * 31 + pixel;
+    }
+    return sum;
+}
+
+} // namespace sim
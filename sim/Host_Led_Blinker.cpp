@@ -0,0 +1,16 @@
+// LED blinking has no visible effect on the host; starting a pattern is
+// reported to the scenario, which uses it as the unit's "ready" cue.
+#include "Led_Blinker.h"
+
+void ledBlinkInit() {
+}
+
+void ledBlinkStart(uint32_t pin, std::chrono::milliseconds halfPeriod) {
+    (void)halfPeriod;
+    if (sim::onBlink) {
+        sim::onBlink((int)pin);
+    }
+}
+
+void ledBlinkStop() {
+}
@@ -0,0 +1,19 @@
+// Register blocks and board data the portable modules expect (see mbed.h)
+#include "LCD_DISCO_F429ZI.h"
+#include "mbed.h"
+
+static DWT_Type dwt = {};
+static CoreDebug_Type coreDebug = {};
+static RNG_TypeDef rng = { 0, RNG_SR_DRDY, {} };
+static RCC_TypeDef rcc = {};
+
+DWT_Type *const DWT = &dwt;
+CoreDebug_Type *const CoreDebug = &coreDebug;
+RNG_TypeDef *const RNG = &rng;
+RCC_TypeDef *const RCC = &rcc;
+
+sFONT Font8 = { nullptr, 5, 8 };
+sFONT Font12 = { nullptr, 7, 12 };
+sFONT Font16 = { nullptr, 11, 16 };
+sFONT Font20 = { nullptr, 14, 20 };
+sFONT Font24 = { nullptr, 17, 24 };
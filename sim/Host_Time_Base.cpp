@@ -0,0 +1,33 @@
+// The host has a single clock: TIM2 is the virtual clock, so there is no
+// drift to estimate. Wall time is the virtual clock counted from a fixed
+// start date, moved by timebaseSetWall().
+#include "Time_Base.h"
+
+static uint64_t start_us = 1767225600ULL * 1000000; // 2026-01-01 00:00:00 UTC
+
+bool timebaseInit(EventQueue &) {
+    return false;
+}
+
+void timebaseSample() {
+}
+
+void timebaseRestart() {
+}
+
+void timebaseSetWall(uint32_t seconds) {
+    start_us = (uint64_t)seconds * 1000000 - sim::now();
+}
+
+int32_t timebaseDrift_ppb() {
+    return 0;
+}
+
+uint32_t timebaseCorrect(uint32_t us) {
+    return us;
+}
+
+uint64_t timebaseWall(uint32_t stamp) {
+    uint64_t now = sim::now();
+    return start_us + now - (uint32_t)((uint32_t)now - stamp);
+}
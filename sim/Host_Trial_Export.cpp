@@ -0,0 +1,61 @@
+// Export without a UART: trials go to the scenario (sim::onTrial), text
+// to sim::onText, and a flush marks the end of a session (sim::onFlush).
+#include "Trial_Export.h"
+
+static ExportConfig exportConfig;
+static void (*commandHandler)(char) = nullptr;
+
+uint16_t crc16(const uint8_t *data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+void exportInit(const ExportConfig &config) {
+    exportConfig = config;
+}
+
+void exportTrial(const TrialRecord &record, uint64_t onset_us) {
+    (void)onset_us;
+    if (sim::onTrial) {
+        sim::onTrial(record);
+    }
+}
+
+void exportSessionStart() {
+}
+
+void exportFlush() {
+    if (sim::onFlush) {
+        sim::onFlush();
+    }
+}
+
+void exportText(const char *text, size_t length) {
+    if (sim::onText) {
+        sim::onText(text, length);
+    }
+}
+
+void exportOnCommand(void (*handler)(char)) {
+    commandHandler = handler;
+}
+
+uint32_t exportDropped() {
+    return 0;
+}
+
+namespace sim {
+
+void sendCommand(char c) {
+    if (commandHandler) {
+        commandHandler(c);
+    }
+}
+
+} // namespace sim
@@ -0,0 +1,26 @@
+// No bus on the host: a collector merges only its own trials, and a unit's
+// trials go nowhere.
+#include "Unit_Link.h"
+
+static LinkRole role = LinkRole::Off;
+static void (*trialHandler)(uint8_t unit, const LinkTrial &trial) = nullptr;
+
+void linkInit(const LinkConfig &config, EventQueue &queue) {
+    (void)queue;
+    role = config.role;
+}
+
+void linkTrial(uint8_t profile, const TrialRecord &record) {
+    LinkTrial trial = { profile, record.flags, record.index, record.reaction_us };
+    if (role == LinkRole::Collector && trialHandler) {
+        trialHandler(0, trial);
+    }
+}
+
+void linkOnTrial(void (*handler)(uint8_t unit, const LinkTrial &trial)) {
+    trialHandler = handler;
+}
+
+uint32_t linkDropped() {
+    return 0;
+}
@@ -0,0 +1,45 @@
+/**
+ * =====================================================
+ * LCD_DISCO_F429ZI (host) – panel object and fonts for the simulation
+ * =====================================================
+ *
+ * The firmware only constructs the panel and hands it to Lcd_Renderer;
+ * the host renderer (Host_Lcd_Renderer.cpp) draws into RAM instead. Fonts
+ * carry their metrics only.
+ *
+ * =====================================================
+ */
+
+#ifndef SIM_LCD_DISCO_F429ZI_H
+#define SIM_LCD_DISCO_F429ZI_H
+
+#include <cstdint>
+
+struct sFONT {
+    const uint8_t *table;
+    uint16_t Width;
+    uint16_t Height;
+};
+
+extern sFONT Font8, Font12, Font16, Font20, Font24;
+
+#define LCD_COLOR_BLUE 0xFF0000FFu
+#define LCD_COLOR_GREEN 0xFF00FF00u
+#define LCD_COLOR_RED 0xFFFF0000u
+#define LCD_COLOR_MAGENTA 0xFFFF00FFu
+#define LCD_COLOR_WHITE 0xFFFFFFFFu
+#define LCD_COLOR_BLACK 0xFF000000u
+#define LCD_COLOR_DARKBLUE 0xFF000080u
+#define LCD_COLOR_GRAY 0xFF808080u
+#define LCD_COLOR_LIGHTGRAY 0xFFD3D3D3u
+#define LCD_COLOR_ORANGE 0xFFFFA500u
+
+class LCD_DISCO_F429ZI {
+public:
+    void DisplayOn() {
+    }
+    void DisplayOff() {
+    }
+};
+
+#endif // SIM_LCD_DISCO_F429ZI_H
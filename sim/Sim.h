@@ -0,0 +1,108 @@
+/**
+ * =====================================================
+ * Sim – host simulation core
+ * =====================================================
+ *
+ * Virtual clock, event scheduler and pin model behind the host mbed.h and
+ * the host implementations of the hardware modules (Host_*.cpp). The
+ * firmware itself compiles unchanged against them.
+ *
+ * Execution model, matching the target's priorities:
+ *   - Timer expiries and input edges are interrupts. They run one at a
+ *     time, in virtual-time order, and the clock jumps straight to each.
+ *   - EventQueue work (the deferred thread) runs before the clock moves
+ *     on, in posting order, and takes no virtual time.
+ *   - The main thread runs whenever it waits on EventFlags whose flags
+ *     are already set; otherwise its wait drives step().
+ *
+ * Virtual time is in microseconds; TIM2 sees its low 32 bits, so long
+ * runs cross the counter wrap like the real timer.
+ *
+ * =====================================================
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include "Trial_Record.h"
+#include <cstdint>
+#include <functional>
+
+namespace sim {
+
+using Handler = std::function<void()>;
+
+// ---- Clock and scheduling ----
+
+uint64_t now();
+
+/**
+ * @brief Runs isr as an interrupt at virtual time at (or now, if earlier).
+ */
+void schedule(uint64_t at, Handler isr);
+
+/**
+ * @brief Queues thread work; runs before the next interrupt.
+ */
+void post(Handler work);
+
+/**
+ * @brief Runs the next piece of work or interrupt.
+ * @return false if nothing is left to happen.
+ */
+bool step();
+
+// Host wall-clock cost of everything step() ran, split by context
+struct Cost {
+    uint64_t count;
+    uint64_t ns;
+};
+const Cost &interruptCost();
+const Cost &workCost();
+
+// ---- Pins ----
+
+/**
+ * @brief Registers an input; edge(level) runs on every change of level.
+ */
+void attachInput(int pin, int level, std::function<void(int level)> edge);
+
+/**
+ * @brief Drives an input pin. Call from an interrupt (a scheduled handler).
+ */
+void setPin(int pin, int level);
+int readPin(int pin);
+
+/**
+ * @brief Called by DigitalOut on every write.
+ */
+void writeOutput(int pin, int value);
+
+// ---- TIM2 input capture ----
+
+void armCapture(int pin, int pressed); // Forget earlier edges, latch the next change of pin to pressed
+bool captured(uint32_t &time);   // First press edge since armCapture(), if any
+
+// ---- Hardware RNG ----
+
+void seed(uint64_t value);
+uint32_t random32();
+
+// ---- Headless display and serial port (Host_Lcd_Renderer, Host_Trial_Export) ----
+
+const char *screenText(uint16_t y);  // Characters in the glyph row at pixel row y
+uint32_t framesPresented();
+uint32_t framebufferChecksum();
+void sendCommand(char c);            // A byte "received" on the VCP; call from an interrupt
+
+// ---- Hooks for the scenario driving the simulation ----
+
+extern void (*onOutput)(int pin, int value);         // DigitalOut written
+extern void (*onBlink)(int pin);                     // LED blink started (GPIOG pin number)
+extern void (*onTrial)(const TrialRecord &record);   // Trial exported
+extern void (*onFlush)();                            // Export flushed (session end)
+extern void (*onText)(const char *text, size_t length); // Text export (diagnostic dumps)
+
+} // namespace sim
+
+#endif // SIM_H
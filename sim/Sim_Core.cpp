@@ -0,0 +1,157 @@
+#include "Sim.h"
+#include <chrono>
+#include <deque>
+#include <queue>
+#include <vector>
+
+namespace sim {
+
+void (*onOutput)(int pin, int value) = nullptr;
+void (*onBlink)(int pin) = nullptr;
+void (*onTrial)(const TrialRecord &record) = nullptr;
+void (*onFlush)() = nullptr;
+void (*onText)(const char *text, size_t length) = nullptr;
+
+namespace {
+
+struct TimerEvent {
+    uint64_t at;
+    uint64_t order;   // Ties run in scheduling order
+    Handler isr;
+};
+
+struct Later {
+    bool operator()(const TimerEvent &a, const TimerEvent &b) const {
+        return (a.at != b.at) ? a.at > b.at : a.order > b.order;
+    }
+};
+
+std::priority_queue<TimerEvent, std::vector<TimerEvent>, Later> timers;
+std::deque<Handler> work;
+uint64_t clock = 0;
+uint64_t order = 0;
+Cost interrupts = { 0, 0 };
+Cost thread = { 0, 0 };
+
+constexpr int pinCount = 256;
+
+struct Input {
+    std::function<void(int level)> edge;
+    int level = 1;
+};
+
+// InterruptIn objects register from static constructors in other files,
+// so the table is built on first use rather than at static init
+Input *inputs() {
+    static Input table[pinCount];
+    return table;
+}
+
+int capturePin = -1;
+int captureLevel = 1;    // Level of a press on capturePin
+bool captureLatched = false;
+uint32_t captureTime = 0;
+
+uint64_t rngState = 0x9E3779B97F4A7C15ULL;
+
+void timed(const Handler &handler, Cost &cost) {
+    auto start = std::chrono::steady_clock::now();
+    handler();
+    auto end = std::chrono::steady_clock::now();
+    cost.count++;
+    cost.ns += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+} // namespace
+
+uint64_t now() {
+    return clock;
+}
+
+void schedule(uint64_t at, Handler isr) {
+    timers.push({ (at < clock) ? clock : at, order++, std::move(isr) });
+}
+
+void post(Handler handler) {
+    work.push_back(std::move(handler));
+}
+
+bool step() {
+    if (!work.empty()) {
+        Handler handler = std::move(work.front());
+        work.pop_front();
+        timed(handler, thread);
+        return true;
+    }
+    if (timers.empty()) {
+        return false;
+    }
+    TimerEvent event = timers.top();
+    timers.pop();
+    clock = event.at;
+    timed(event.isr, interrupts);
+    return true;
+}
+
+const Cost &interruptCost() {
+    return interrupts;
+}
+
+const Cost &workCost() {
+    return thread;
+}
+
+void attachInput(int pin, int level, std::function<void(int level)> edge) {
+    inputs()[pin].level = level;
+    inputs()[pin].edge = std::move(edge);
+}
+
+void setPin(int pin, int level) {
+    Input &input = inputs()[pin];
+    if (input.level == level) {
+        return;
+    }
+    input.level = level;
+    if (level == captureLevel && pin == capturePin && !captureLatched) {
+        captureLatched = true; // What the one-shot DMA latch would keep
+        captureTime = (uint32_t)clock;
+    }
+    if (input.edge) {
+        input.edge(level);
+    }
+}
+
+int readPin(int pin) {
+    return inputs()[pin].level;
+}
+
+void writeOutput(int pin, int value) {
+    if (onOutput) {
+        onOutput(pin, value);
+    }
+}
+
+void armCapture(int pin, int pressed) {
+    capturePin = pin;
+    captureLevel = pressed;
+    captureLatched = false;
+}
+
+bool captured(uint32_t &time) {
+    time = captureTime;
+    return captureLatched;
+}
+
+void seed(uint64_t value) {
+    rngState = value ? value : 0x9E3779B97F4A7C15ULL;
+}
+
+uint32_t random32() {
+    // xorshift64*
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return (uint32_t)((rngState * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+} // namespace sim
@@ -0,0 +1,343 @@
+/**
+ * =====================================================
+ * Sim_Main – scripted subject and benchmark report
+ * =====================================================
+ *
+ * Runs the unchanged firmware (its main() renamed firmwareMain() by the
+ * Makefile) against a simulated subject who reads the LEDs and presses
+ * BUTTON1 the way a person would:
+ *   - green stimulus: press after an ex-Gaussian reaction time, with a
+ *     share of anticipations (far too fast) and lapses (far too slow);
+ *   - red "result ready": press for the next trial, sometimes followed by
+ *     an early press during the foreperiod;
+ *   - idle / session-complete blinks: start, view the board, restart.
+ *
+ * Every exported trial is checked against the script (the captured
+ * reaction time must be exact, the validation flag must match what was
+ * injected) and every session's statistics against a double-precision
+ * reference. The report then gives the host cost of the FSM paths.
+ *
+ *   reaction_sim [--trials N] [--seed S] [--screen] [--profile]
+ *
+ * =====================================================
+ */
+
+#include "Cycle_Profiler.h"
+#include "Fixed_Format.h"
+#include "Session_Stats.h"
+#include "mbed.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+int firmwareMain();
+void dumpProfile();
+extern SessionStats sessionStats;
+extern uint32_t pB;
+
+namespace {
+
+// ---- Options ----
+
+uint64_t trialTarget = 200000;
+uint64_t seedValue = 1;
+bool showScreen = false;
+bool showProfile = false;
+
+// ---- Subject model ----
+
+constexpr double rtMu_us = 260000;      // Ex-Gaussian: normal part mean
+constexpr double rtSigma_us = 35000;    // and spread
+constexpr double rtTau_us = 60000;      // plus an exponential tail
+constexpr double anticipationRate = 0.02;
+constexpr double lapseRate = 0.01;
+constexpr double earlyRate = 0.03;      // Presses again during the foreperiod
+constexpr uint64_t holdTime_us = 80000; // Button held down
+constexpr uint64_t resultDelay_us = 300000;
+constexpr uint64_t menuDelay_us = 1000000;
+constexpr uint64_t boardDelay_us = 1500000;
+
+enum Script { Normal, Early, Anticipation, Lapse, scriptCount };
+enum Verdict { Accepted, FlaggedEarly, FlaggedAnticipation, FlaggedLapse, FlaggedOutlier, verdictCount };
+
+const char *const scriptNames[scriptCount] = { "normal", "early", "anticipation", "lapse" };
+
+std::mt19937_64 subject;
+Script script = Normal;   // What the trial in progress was scripted as
+uint32_t scriptedRt = 0;
+uint64_t intent = 0;      // Newer cues cancel presses still pending for older ones
+
+double uniform(double lo, double hi) {
+    return std::uniform_real_distribution<double>(lo, hi)(subject);
+}
+
+void press() {
+    sim::setPin(BUTTON1, 1); // Active high, like the board's button
+    sim::schedule(sim::now() + holdTime_us, [] { sim::setPin(BUTTON1, 0); });
+}
+
+void pressAfter(uint64_t delay_us, void (*then)() = nullptr) {
+    uint64_t mine = ++intent;
+    sim::schedule(sim::now() + delay_us, [mine, then] {
+        if (mine == intent) {
+            press();
+            if (then) {
+                then();
+            }
+        }
+    });
+}
+
+// A trial has just started: maybe jump the gun during the foreperiod
+void trialStarted() {
+    script = Normal;
+    if (uniform(0, 1) < earlyRate) {
+        script = Early;
+        pressAfter((uint64_t)uniform(200000, 900000));
+    }
+}
+
+void stimulusOn() {
+    double u = uniform(0, 1);
+    double rt;
+    if (u < anticipationRate) {
+        script = Anticipation;
+        rt = uniform(20000, 90000);
+    } else if (u < anticipationRate + lapseRate) {
+        script = Lapse;
+        rt = uniform(1200000, 2000000);
+    } else {
+        script = Normal;
+        rt = std::normal_distribution<double>(rtMu_us, rtSigma_us)(subject) +
+             std::exponential_distribution<double>(1.0 / rtTau_us)(subject);
+        rt = std::max(rt, 1.0);
+    }
+    scriptedRt = (uint32_t)rt;
+    pressAfter(scriptedRt);
+}
+
+void output(int pin, int value) {
+    if (value == 0) {
+        return;
+    }
+    if (pin == PG_13) {
+        stimulusOn();
+    } else if (pin == PG_14) {
+        pressAfter(resultDelay_us, &trialStarted);
+    }
+}
+
+// Blink pins are GPIOG pin numbers (Led_Blinker)
+void blink(int pin) {
+    if (pin == 13) {
+        pressAfter(menuDelay_us, &trialStarted); // Idle: start a session
+    } else if (pin == 14) {
+        pressAfter(menuDelay_us, [] {            // Complete: open the board,
+            pressAfter(boardDelay_us);           // then back to idle
+        });
+    }
+}
+
+// ---- Checks ----
+
+uint64_t trials = 0;
+uint64_t sessions = 0;
+uint64_t outcomes[scriptCount][verdictCount] = {};
+uint64_t timingChecked = 0;
+uint64_t timingErrors = 0;
+uint32_t bestAccepted = UINT32_MAX;
+std::vector<uint32_t> sessionTimes;
+double maxMeanError_us = 0;
+double maxSdError_us = 0;
+uint64_t statsErrors = 0; // Count/min/max mismatches
+uint64_t bestErrors = 0;
+std::chrono::steady_clock::time_point wallStart;
+
+Verdict verdict(uint8_t flags) {
+    if (flags & TRIAL_EARLY) {
+        return FlaggedEarly;
+    }
+    if (flags & TRIAL_ANTICIPATION) {
+        return FlaggedAnticipation;
+    }
+    if (flags & TRIAL_LAPSE) {
+        return FlaggedLapse;
+    }
+    if (flags & TRIAL_OUTLIER) {
+        return FlaggedOutlier;
+    }
+    return Accepted;
+}
+
+void trial(const TrialRecord &record) {
+    trials++;
+    Verdict v = verdict(record.flags);
+    outcomes[script][v]++;
+
+    if (script != Early && v != FlaggedEarly) {
+        timingChecked++;
+        if (record.reaction_us != scriptedRt) {
+            timingErrors++;
+        }
+    }
+    if (v == Accepted) {
+        sessionTimes.push_back(record.reaction_us);
+        bestAccepted = std::min(bestAccepted, record.reaction_us);
+    }
+}
+
+void report();
+
+void sessionEnd() {
+    sessions++;
+
+    double sum = 0;
+    for (uint32_t us : sessionTimes) {
+        sum += us;
+    }
+    size_t n = sessionTimes.size();
+    double mean = n ? sum / n : 0;
+    double m2 = 0;
+    for (uint32_t us : sessionTimes) {
+        m2 += (us - mean) * (us - mean);
+    }
+    double sd = (n > 1) ? std::sqrt(m2 / (n - 1)) : 0;
+
+    if (sessionStats.count != n) {
+        statsErrors++;
+    } else if (n) {
+        auto range = std::minmax_element(sessionTimes.begin(), sessionTimes.end());
+        if (sessionStats.min != *range.first || sessionStats.max != *range.second) {
+            statsErrors++;
+        }
+        maxMeanError_us = std::max(maxMeanError_us, std::fabs(sessionStats.mean - mean));
+        maxSdError_us = std::max(maxSdError_us, std::fabs(std::sqrt(sessionStats.variance()) - sd));
+    }
+    if (pB != bestAccepted) {
+        bestErrors++;
+    }
+    sessionTimes.clear();
+
+    if (trials >= trialTarget) {
+        report();
+        std::exit((timingErrors || statsErrors || bestErrors) ? 1 : 0);
+    }
+}
+
+void text(const char *s, size_t length) {
+    fwrite(s, 1, length, stdout);
+}
+
+// ---- Report ----
+
+double perOp_ns(const sim::Cost &cost) {
+    return cost.count ? (double)cost.ns / cost.count : 0;
+}
+
+template <typename F>
+double benchmark_ns(F body) {
+    constexpr uint32_t iterations = 1000000;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        body(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+void report() {
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    double virtual_s = sim::now() / 1e6;
+
+    printf("Trials %" PRIu64 " in %" PRIu64 " sessions, seed %" PRIu64 "\n", trials, sessions, seedValue);
+    printf("Virtual time %.0f s, wall time %.3f s (%.0fx real time, %.0f trials/s)\n", virtual_s, wall_s,
+           virtual_s / wall_s, trials / wall_s);
+    printf("Frames presented %" PRIu32 ", framebuffer checksum %08" PRIx32 "\n\n", sim::framesPresented(),
+           sim::framebufferChecksum());
+
+    printf("%-14s %10s %10s %10s %10s %10s\n", "scripted", "accepted", "early", "anticip.", "lapse", "outlier");
+    for (int s = 0; s < scriptCount; s++) {
+        printf("%-14s", scriptNames[s]);
+        for (int v = 0; v < verdictCount; v++) {
+            printf(" %10" PRIu64, outcomes[s][v]);
+        }
+        printf("\n");
+    }
+
+    printf("\nCapture: %" PRIu64 " of %" PRIu64 " reaction times differ from the script\n", timingErrors,
+           timingChecked);
+    printf("Session stats: %" PRIu64 " count/min/max mismatches, max |mean error| %.3f us, max |SD error| %.3f us\n",
+           statsErrors, maxMeanError_us, maxSdError_us);
+    printf("Personal best: %" PRIu64 " sessions disagree with the reference\n\n", bestErrors);
+
+    printf("Host cost per interrupt %.0f ns (%" PRIu64 "), per deferred work item %.0f ns (%" PRIu64 ")\n",
+           perOp_ns(sim::interruptCost()), sim::interruptCost().count, perOp_ns(sim::workCost()),
+           sim::workCost().count);
+
+    char buffer[64];
+    volatile char sink = 0;
+    double fixed = benchmark_ns([&](uint32_t i) {
+        FormatBuffer(buffer).text("The time taken was ").ms<3, 4>(i).text(" ms");
+        sink = sink + buffer[20];
+    });
+    double printf_ = benchmark_ns([&](uint32_t i) {
+        snprintf(buffer, sizeof(buffer), "The time taken was %.3f ms", i / 1000.0f);
+        sink = sink + buffer[20];
+    });
+    printf("Result line: FormatBuffer %.1f ns, snprintf %.1f ns\n", fixed, printf_);
+
+    if (showProfile) {
+        printf("\n");
+        dumpProfile(); // Same CSV as the 'p' command, in host nanoseconds
+    }
+
+    if (showScreen) {
+        printf("\nScreen:\n");
+        for (uint16_t y = 0; y < 320; y += 2) {
+            const char *row = sim::screenText(y);
+            if (row && *row) {
+                printf("%3u | %s\n", y, row);
+            }
+        }
+    }
+    fflush(stdout);
+}
+
+void usage(const char *name) {
+    fprintf(stderr, "usage: %s [--trials N] [--seed S] [--screen] [--profile]\n", name);
+    std::exit(2);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--trials") && i + 1 < argc) {
+            trialTarget = strtoull(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seedValue = strtoull(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--screen")) {
+            showScreen = true;
+        } else if (!strcmp(argv[i], "--profile")) {
+            showProfile = true;
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    sim::seed(seedValue);
+    subject.seed(seedValue);
+    sim::onOutput = &output;
+    sim::onBlink = &blink;
+    sim::onTrial = &trial;
+    sim::onFlush = &sessionEnd;
+    sim::onText = &text;
+
+    wallStart = std::chrono::steady_clock::now();
+    return firmwareMain(); // Never returns: sessionEnd() exits once the target is reached
+}
@@ -0,0 +1,423 @@
+/**
+ * =====================================================
+ * mbed.h (host) – the Mbed OS 6 subset the firmware uses, on Sim
+ * =====================================================
+ *
+ * Same names and signatures as Mbed, so the firmware sources compile
+ * unchanged; behaviour comes from the simulation core (Sim.h). Timers run
+ * on the virtual clock, InterruptIn edges come from setPin(), EventQueue
+ * work goes to the simulated deferred thread and EventFlags::wait_any()
+ * advances the simulation until a flag it waits for is set.
+ *
+ * The few registers touched outside the Host_*.cpp modules are here too:
+ * the DWT cycle counter (host steady clock, in ns) and the RNG (seeded
+ * xorshift).
+ *
+ * =====================================================
+ */
+
+#ifndef SIM_MBED_H
+#define SIM_MBED_H
+
+#include "Sim.h"
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <set>
+#include <utility>
+
+using namespace std::chrono_literals;
+
+// ---- Pins (Mbed STM32 encoding: port << 4 | pin) ----
+
+enum PinName {
+    PA_0 = 0x00,
+    PA_6 = 0x06,
+    PA_8 = 0x08,
+    PA_15 = 0x0F,
+    PC_9 = 0x29,
+    PC_11 = 0x2B,
+    PG_13 = 0x6D,
+    PG_14 = 0x6E,
+    BUTTON1 = PA_0,
+    NC = -1,
+};
+
+enum PinMode {
+    PullNone,
+    PullUp,
+    PullDown,
+};
+
+// ---- Callbacks ----
+
+template <typename Signature>
+class Callback;
+
+template <typename R, typename... Args>
+class Callback<R(Args...)> {
+public:
+    Callback() = default;
+    Callback(std::nullptr_t) {
+    }
+    Callback(R (*function)(Args...)) {
+        if (function) {
+            target = function;
+        }
+    }
+    template <typename T>
+    Callback(T *object, R (T::*method)(Args...)) : target([object, method](Args... args) {
+        return (object->*method)(args...);
+    }) {
+    }
+    template <typename F, typename = decltype(std::declval<F>()(std::declval<Args>()...))>
+    Callback(F function) : target(std::move(function)) {
+    }
+
+    R operator()(Args... args) const {
+        return target(args...);
+    }
+    explicit operator bool() const {
+        return (bool)target;
+    }
+
+private:
+    std::function<R(Args...)> target;
+};
+
+template <typename R, typename... Args>
+Callback<R(Args...)> callback(R (*function)(Args...)) {
+    return Callback<R(Args...)>(function);
+}
+
+template <typename T, typename R, typename... Args>
+Callback<R(Args...)> callback(T *object, R (T::*method)(Args...)) {
+    return Callback<R(Args...)>(object, method);
+}
+
+// ---- Digital I/O ----
+
+class DigitalOut {
+public:
+    DigitalOut(PinName pin, int value = 0) : pin(pin), value(value) {
+    }
+    void write(int v) {
+        value = v;
+        sim::writeOutput(pin, v);
+    }
+    int read() const {
+        return value;
+    }
+    DigitalOut &operator=(int v) {
+        write(v);
+        return *this;
+    }
+    operator int() const {
+        return value;
+    }
+
+private:
+    PinName pin;
+    int value;
+};
+
+class InterruptIn {
+public:
+    InterruptIn(PinName pin, PinMode mode = PullNone) : pin(pin) {
+        (void)mode;
+        // BUTTON1 is pulled down on the board; every other input idles high
+        sim::attachInput(pin, pin == BUTTON1 ? 0 : 1, [this](int level) {
+            const Callback<void()> &handler = level ? riseHandler : fallHandler;
+            if (handler) {
+                handler();
+            }
+        });
+    }
+    void fall(Callback<void()> handler) {
+        fallHandler = handler;
+    }
+    void rise(Callback<void()> handler) {
+        riseHandler = handler;
+    }
+    int read() const {
+        return sim::readPin(pin);
+    }
+    operator int() const {
+        return read();
+    }
+
+private:
+    PinName pin;
+    Callback<void()> fallHandler;
+    Callback<void()> riseHandler;
+};
+
+// No device answers on the host bus
+class I2C {
+public:
+    I2C(PinName sda, PinName scl) {
+        (void)sda;
+        (void)scl;
+    }
+    void frequency(int hz) {
+        (void)hz;
+    }
+    int write(int address, const char *data, int length, bool repeated = false) {
+        (void)address;
+        (void)data;
+        (void)length;
+        (void)repeated;
+        return -1;
+    }
+    int read(int address, char *data, int length, bool repeated = false) {
+        (void)address;
+        (void)data;
+        (void)length;
+        (void)repeated;
+        return -1;
+    }
+};
+
+// ---- Time ----
+
+class Timer {
+public:
+    void start() {
+        if (!running) {
+            running = true;
+            started = sim::now();
+        }
+    }
+    void stop() {
+        if (running) {
+            total += sim::now() - started;
+            running = false;
+        }
+    }
+    void reset() {
+        total = 0;
+        started = sim::now();
+    }
+    std::chrono::microseconds elapsed_time() const {
+        return std::chrono::microseconds(total + (running ? sim::now() - started : 0));
+    }
+
+private:
+    bool running = false;
+    uint64_t started = 0;
+    uint64_t total = 0;
+};
+
+class Timeout {
+public:
+    void attach(Callback<void()> handler, std::chrono::microseconds delay) {
+        uint64_t armed = ++generation; // Drops any earlier, still pending expiry
+        sim::schedule(sim::now() + delay.count(), [this, armed, handler] {
+            if (armed == generation) {
+                handler();
+            }
+        });
+    }
+    void detach() {
+        ++generation;
+    }
+
+private:
+    uint64_t generation = 0;
+};
+
+class LowPowerTimeout : public Timeout {
+};
+
+// ---- RTOS ----
+
+enum osPriority {
+    osPriorityLow = 8,
+    osPriorityBelowNormal = 16,
+    osPriorityNormal = 24,
+    osPriorityAboveNormal = 32,
+    osPriorityHigh = 40,
+};
+
+constexpr unsigned EVENTS_EVENT_SIZE = 64;
+
+class EventQueue {
+public:
+    explicit EventQueue(unsigned size = 32 * EVENTS_EVENT_SIZE) {
+        (void)size;
+    }
+    template <typename F, typename... Args>
+    int call(F work, Args... args) {
+        sim::post([work, args...] { work(args...); });
+        return ++lastId;
+    }
+    template <typename F>
+    int call_in(std::chrono::milliseconds delay, F work) {
+        sim::schedule(sim::now() + std::chrono::microseconds(delay).count(), [work] {
+            sim::post(work);
+        });
+        return ++lastId;
+    }
+    template <typename F>
+    int call_every(std::chrono::milliseconds period, F work) {
+        int id = ++lastId;
+        repeat(id, std::chrono::microseconds(period).count(), work);
+        return id;
+    }
+    bool cancel(int id) {
+        return cancelled.insert(id).second;
+    }
+    void dispatch_forever() {
+        // The simulation drains every queue from step()
+    }
+
+private:
+    template <typename F>
+    void repeat(int id, uint64_t period_us, F work) {
+        sim::schedule(sim::now() + period_us, [this, id, period_us, work] {
+            if (cancelled.count(id)) {
+                return;
+            }
+            sim::post(work);
+            repeat(id, period_us, work);
+        });
+    }
+
+    int lastId = 0;
+    std::set<int> cancelled;
+};
+
+class Thread {
+public:
+    Thread(osPriority priority = osPriorityNormal, uint32_t stack = 0, unsigned char *memory = nullptr,
+           const char *name = nullptr) {
+        (void)priority;
+        (void)stack;
+        (void)memory;
+        (void)name;
+    }
+    int start(Callback<void()> task) {
+        (void)task; // Its queue is run by the simulation instead
+        return 0;
+    }
+};
+
+class EventFlags {
+public:
+    uint32_t set(uint32_t flags) {
+        value |= flags;
+        return value;
+    }
+    uint32_t clear(uint32_t flags) {
+        uint32_t old = value;
+        value &= ~flags;
+        return old;
+    }
+    uint32_t get() const {
+        return value;
+    }
+    uint32_t wait_any(uint32_t flags, uint32_t timeout = UINT32_MAX, bool clear = true) {
+        (void)timeout;
+        while (!(value & flags)) {
+            if (!sim::step()) {
+                fprintf(stderr, "sim: nothing left to run while waiting for flags 0x%x\n", (unsigned)flags);
+                exit(1);
+            }
+        }
+        uint32_t taken = value & flags;
+        if (clear) {
+            value &= ~taken;
+        }
+        return taken;
+    }
+
+private:
+    uint32_t value = 0;
+};
+
+namespace ThisThread {
+template <typename Duration>
+void sleep_for(Duration) {
+}
+} // namespace ThisThread
+
+// ---- Platform ----
+
+#define MBED_PACKED(declaration) declaration __attribute__((packed))
+
+inline void __enable_irq() {
+}
+inline void __disable_irq() {
+}
+inline void set_time(time_t) {
+}
+inline void sleep_manager_lock_deep_sleep() {
+}
+inline void sleep_manager_unlock_deep_sleep() {
+}
+
+inline uint32_t __CLZ(uint32_t value) {
+    return value ? __builtin_clz(value) : 32;
+}
+
+// ---- Registers used by the portable modules ----
+
+// DWT CYCCNT reads the host steady clock, so probes report nanoseconds
+struct HostCycleCounter {
+    operator uint32_t() const {
+        return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+    HostCycleCounter &operator=(uint32_t) {
+        return *this;
+    }
+};
+
+struct DWT_Type {
+    uint32_t CTRL;
+    HostCycleCounter CYCCNT;
+};
+
+struct CoreDebug_Type {
+    uint32_t DEMCR;
+};
+
+// RNG DR draws a fresh word on every read, SR always reports data ready
+struct HostRandomRegister {
+    operator uint32_t() const {
+        return sim::random32();
+    }
+};
+
+struct RNG_TypeDef {
+    uint32_t CR;
+    uint32_t SR;
+    HostRandomRegister DR;
+};
+
+struct RCC_TypeDef {
+    uint32_t AHB2ENR;
+};
+
+extern DWT_Type *const DWT;
+extern CoreDebug_Type *const CoreDebug;
+extern RNG_TypeDef *const RNG;
+extern RCC_TypeDef *const RCC;
+
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+#define RCC_AHB2ENR_RNGEN (1UL << 6)
+#define RNG_CR_RNGEN (1UL << 2)
+#define RNG_SR_DRDY (1UL << 0)
+#define RNG_SR_CECS (1UL << 1)
+#define RNG_SR_SECS (1UL << 2)
+
+#endif // SIM_MBED_H